@@ -4,18 +4,24 @@
 #include <memory>
 #include <utility>
 #include <algorithm>
+#include <bit>
 #include <functional>
 #include <type_traits>
 #include <filesystem>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <format>
 #include <execution>
 #include <source_location>
 #include <cstdint>
 #include <string>
 #include <string_view>
+#include <array>
+#include <optional>
 #include <vector>
+#include <queue>
+#include <limits>
 #include <unordered_set>
 
 #include "src/Core.h"
@@ -1,10 +1,20 @@
 #include "Application.h"
 
+// Longest sleep between two polls while waiting for the next round, the start time may still change
+constexpr std::chrono::seconds MAX_ROUND_WAIT(30);
+
+// Poll interval while waiting for a round without a known start time
+constexpr std::chrono::seconds ROUND_POLL_INTERVAL(1);
+
+// Delay before fetching again after a failed fetch
+constexpr std::chrono::milliseconds FETCH_RETRY_INTERVAL(20);
+
 namespace Snake {
 	Application::Application(std::string_view name, uint32_t windowWidth, uint32_t windowHeight,
 													 uint32_t framerateLimit, uint32_t serverTickRate)
 		: m_Name(name), m_WindowWidth(windowWidth), m_WindowHeight(windowHeight),
-		m_FramerateLimit(framerateLimit), m_ServerTickRate(serverTickRate) {
+		m_FramerateLimit(framerateLimit), m_ServerTickRate(serverTickRate),
+		m_TickScheduler(serverTickRate == 0 ? 1000.0 : 1000.0 / serverTickRate) {
 		CORE_ASSERT(m_Instance == nullptr, "Application already exists!");
 		m_Instance = this;
 
@@ -37,32 +47,45 @@ namespace Snake {
 	}
 
 	void Application::UpdateLoop() {
-		double lastUpdateTime = 0.0;
-		double serverTickLimitSec = m_ServerTickRate == 0.0 ? 0.0 : 1.0 / m_ServerTickRate;
+		while (m_Running) {
+			bool isFresh = m_Server.Update();
+
+			if (m_Server.GetState() == Server::State::WaitingForNextGame) {
+				// Nothing happens until the round starts, the tick phase of the next one is learned anew
+				m_TickScheduler.Reset();
+				std::optional<std::chrono::milliseconds> delay = m_Server.GetNextRoundDelay();
+				std::this_thread::sleep_for(delay ? std::min<std::chrono::milliseconds>(*delay, MAX_ROUND_WAIT) : ROUND_POLL_INTERVAL);
+				continue;
+			}
 
-		Utils::Timer timer;
-		timer.Start();
+			if (m_Server.GetState() != Server::State::Connected) {
+				std::this_thread::sleep_for(ROUND_POLL_INTERVAL);
+				continue;
+			}
 
-		while (m_Running) {
-			timer.Stop();
-			m_UpdateDeltaTime = timer.GetElapsedSec() - lastUpdateTime;
-			if (m_ServerTickRate == 0.0 || m_UpdateDeltaTime.GetSeconds() >= serverTickLimitSec) {
-				//CORE_TRACE("Update loop: {}", m_UpdateDeltaTime.GetMilliseconds());
-				m_Server.Update();
-				if (m_Server.GetState() == Server::State::Connected) {
-					const GameState& gameState = m_Server.GetGameState();
-					if (gameState.tickRemainMs < serverTickLimitSec * 1000 / 2) {
-						CORE_WARN("Sleeping for {} ms!", gameState.tickRemainMs);
-						std::this_thread::sleep_for(std::chrono::milliseconds(gameState.tickRemainMs));
-						continue;
-					}
-
-					m_Game.Update(gameState);
-					m_Server.PrintGameState();
-				}
-
-				lastUpdateTime = timer.GetElapsedSec();
+			if (!isFresh) {
+				// The kept state is the one already planned for, it says nothing about the tick phase either
+				std::this_thread::sleep_for(FETCH_RETRY_INTERVAL);
+				continue;
 			}
+
+			const GameState& gameState = m_Server.GetGameState();
+			if (!m_TickScheduler.Observe(gameState.turn, gameState.tickRemainMs, m_Server.GetRoundTripMs())) {
+				CORE_WARN("Woke up before turn {} ended, waking {:.1f} ms after the tick from now on", gameState.turn,
+									m_TickScheduler.GetWakeDelayMs());
+				m_TickScheduler.SleepUntilNextTick();
+				continue;
+			}
+
+			m_Game.Update(gameState);
+			m_Server.PrintGameState();
+			CORE_INFO("Tick phase error {:.1f} ms, jitter {:.1f} ms, max {:.1f} ms, tick {:.1f} ms, expand {:.3f} ms, snapshot tail {:.3f} ms",
+								m_TickScheduler.GetLastPhaseErrorMs(), m_TickScheduler.GetPhaseJitterMs(), m_TickScheduler.GetMaxPhaseErrorMs(),
+								m_TickScheduler.GetTickMs(), m_Server.GetExpandMs(), m_Server.GetSnapshotTailMs());
+
+			// The time until the next wake-up goes into planning the predicted tick
+			m_Game.Speculate(gameState, Utils::Deadline(m_TickScheduler.GetNextWakeTime()));
+			m_TickScheduler.SleepUntilNextTick();
 		}
 
 		m_Running = false;
@@ -73,7 +96,7 @@ namespace Snake {
 
 		double lastRenderTime = 0.0;
 		double framerateLimitSec = m_FramerateLimit == 0.0 ? 0.0 : 1.0 / m_FramerateLimit;
-		GameState localState;
+		WorldSnapshot localSnapshot;
 
 		Utils::Timer timer;
 		timer.Start();
@@ -84,12 +107,9 @@ namespace Snake {
 
 			if (m_FramerateLimit == 0.0 || m_RenderDeltaTime.GetSeconds() >= framerateLimitSec) {
 				//CORE_TRACE("Render loop: {}", m_RenderDeltaTime.GetMilliseconds());
-				{
-					std::lock_guard<std::mutex> lock(m_ServerMutex);
-					localState = m_Server.GetGameState();
-				}
+				m_Server.CopySnapshot(localSnapshot);
 				m_Renderer.Update(m_RenderDeltaTime);
-				m_Renderer.Render(m_RenderDeltaTime, localState);
+				m_Renderer.Render(m_RenderDeltaTime, localSnapshot);
 
 				lastRenderTime = timer.GetElapsedSec();
 				++m_FrameCounter;
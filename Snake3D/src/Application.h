@@ -6,6 +6,8 @@
 
 #include "Server/Server.h"
 
+#include "Utils/TickScheduler.h"
+
 namespace Snake {
 	class Application {
 	public:
@@ -25,6 +27,10 @@ namespace Snake {
 			m_Server.Send(json);
 		}
 
+		void ConfigurePlannerWorkers(uint32_t workerCount, bool pinWorkers = false) {
+			m_Game.ConfigureWorkers(workerCount, pinWorkers);
+		}
+
 		void SetFramerateLimit(uint32_t limit) noexcept;
 
 		inline const std::string& GetName() const noexcept { return m_Name; }
@@ -37,6 +43,8 @@ namespace Snake {
 
 		inline uint32_t GetServerTickRate() const noexcept { return m_ServerTickRate; }
 
+		inline const Utils::TickScheduler& GetTickScheduler() const noexcept { return m_TickScheduler; }
+
 		static inline Application& Get() noexcept { return *m_Instance; }
 	
 	private:
@@ -56,8 +64,6 @@ namespace Snake {
 		Renderer m_Renderer;
 		Server m_Server;
 
-		std::mutex m_ServerMutex;
-
 		bool m_Running = false;
 		std::thread m_UpdateThread;
 		std::thread m_RenderThread;
@@ -67,8 +73,7 @@ namespace Snake {
 		double m_FramerateLimitSec = 0.0;
 		uint64_t m_FrameCounter = 0;
 
-		Timestep m_UpdateDeltaTime = 0.0;
 		uint32_t m_ServerTickRate = 0;
-		double m_ServerTickLimitSec = 0.0;
+		Utils::TickScheduler m_TickScheduler;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "BitFrontier.h"
+
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define SNAKE_BIT_FRONTIER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define SNAKE_BIT_FRONTIER_SSE2
+#endif
+
+namespace Snake {
+  // Words processed per step by the widest available kernel, ranges are aligned to it
+  constexpr int32_t KERNEL_WORD_COUNT = 4;
+
+  // Input of one direction: the frontier shifted by its offset, limited to cells it may enter.
+  // Directions without an edge mask cannot wrap, they only shift in the zeroed padding.
+  struct ShiftedSource {
+    const uint64_t* nearWords = nullptr;
+    const uint64_t* carryWords = nullptr;
+    const uint64_t* edgeMask = nullptr;
+    int32_t bitShift = 0;
+    bool isForward = true;
+  };
+
+  // next = (union of shifted sources) & free & ~visited and visited |= next, for words in [begin, end).
+  // Returns the range of words that received new cells, empty when the layer reached nothing.
+  static std::pair<int32_t, int32_t> ExpandWords(const std::array<ShiftedSource, DIRECTIONS.size()>& sources,
+                                                 const uint64_t* free, uint64_t* visited, uint64_t* next,
+                                                 int32_t begin, int32_t end) noexcept {
+    int32_t first = end;
+    int32_t last = begin;
+
+    int32_t i = begin;
+#if defined(SNAKE_BIT_FRONTIER_AVX2)
+    for (; i + 4 <= end; i += 4) {
+      __m256i reached = _mm256_setzero_si256();
+      for (const ShiftedSource& source : sources) {
+        __m256i nearBits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source.nearWords + i));
+        __m256i carryBits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source.carryWords + i));
+        __m128i nearCount = _mm_cvtsi32_si128(source.bitShift);
+        __m128i carryCount = _mm_cvtsi32_si128(64 - source.bitShift);
+
+        // Shift counts of 64 produce zero, so word aligned offsets need no special case
+        __m256i shifted = source.isForward
+          ? _mm256_or_si256(_mm256_sll_epi64(nearBits, nearCount), _mm256_srl_epi64(carryBits, carryCount))
+          : _mm256_or_si256(_mm256_srl_epi64(nearBits, nearCount), _mm256_sll_epi64(carryBits, carryCount));
+        if (source.edgeMask != nullptr) {
+          shifted = _mm256_and_si256(shifted, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source.edgeMask + i)));
+        }
+        reached = _mm256_or_si256(reached, shifted);
+      }
+
+      __m256i seen = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(visited + i));
+      reached = _mm256_andnot_si256(seen, _mm256_and_si256(reached, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(free + i))));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(next + i), reached);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(visited + i), _mm256_or_si256(seen, reached));
+
+      if (!_mm256_testz_si256(reached, reached)) {
+        first = std::min(first, i);
+        last = i + 4;
+      }
+    }
+#elif defined(SNAKE_BIT_FRONTIER_SSE2)
+    for (; i + 2 <= end; i += 2) {
+      __m128i reached = _mm_setzero_si128();
+      for (const ShiftedSource& source : sources) {
+        __m128i nearBits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.nearWords + i));
+        __m128i carryBits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.carryWords + i));
+        __m128i nearCount = _mm_cvtsi32_si128(source.bitShift);
+        __m128i carryCount = _mm_cvtsi32_si128(64 - source.bitShift);
+
+        __m128i shifted = source.isForward
+          ? _mm_or_si128(_mm_sll_epi64(nearBits, nearCount), _mm_srl_epi64(carryBits, carryCount))
+          : _mm_or_si128(_mm_srl_epi64(nearBits, nearCount), _mm_sll_epi64(carryBits, carryCount));
+        if (source.edgeMask != nullptr) {
+          shifted = _mm_and_si128(shifted, _mm_loadu_si128(reinterpret_cast<const __m128i*>(source.edgeMask + i)));
+        }
+        reached = _mm_or_si128(reached, shifted);
+      }
+
+      __m128i seen = _mm_loadu_si128(reinterpret_cast<const __m128i*>(visited + i));
+      reached = _mm_andnot_si128(seen, _mm_and_si128(reached, _mm_loadu_si128(reinterpret_cast<const __m128i*>(free + i))));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(next + i), reached);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(visited + i), _mm_or_si128(seen, reached));
+
+      // SSE2 has no test instruction, compare both halves against zero instead
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(reached, _mm_setzero_si128())) != 0xFFFF) {
+        first = std::min(first, i);
+        last = i + 2;
+      }
+    }
+#endif
+
+    for (; i < end; ++i) {
+      uint64_t reached = 0;
+      for (const ShiftedSource& source : sources) {
+        uint64_t shifted = 0;
+        if (source.isForward) {
+          shifted = source.nearWords[i] << source.bitShift;
+          if (source.bitShift != 0) { shifted |= source.carryWords[i] >> (64 - source.bitShift); }
+        } else {
+          shifted = source.nearWords[i] >> source.bitShift;
+          if (source.bitShift != 0) { shifted |= source.carryWords[i] << (64 - source.bitShift); }
+        }
+
+        reached |= source.edgeMask != nullptr ? shifted & source.edgeMask[i] : shifted;
+      }
+
+      reached &= free[i] & ~visited[i];
+      next[i] = reached;
+      visited[i] |= reached;
+
+      if (reached != 0) {
+        first = std::min(first, i);
+        last = i + 1;
+      }
+    }
+
+    return first < last ? std::make_pair(first, last) : std::make_pair(0, 0);
+  }
+
+  void BitFrontier::Prepare(const OccupancyGrid& obstacles) {
+    m_Obstacles = &obstacles;
+
+    if (!(obstacles.GetExtent() == m_Extent) || m_Free.empty()) {
+      m_Extent = obstacles.GetExtent();
+      for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+        const Coords& dir = DIRECTIONS[i];
+        m_Offsets[i] = dir.x + dir.y * static_cast<int32_t>(obstacles.GetStrideY()) + dir.z * static_cast<int32_t>(obstacles.GetStrideZ());
+      }
+
+      m_WordCount = static_cast<int32_t>(obstacles.GetWords().size());
+
+      // Enough to cover the largest shift plus its carry word, rounded so kernels may run past the last word
+      int32_t maxWordShift = static_cast<int32_t>(obstacles.GetStrideZ() >> 6) + 1;
+      m_Padding = (maxWordShift + KERNEL_WORD_COUNT) / KERNEL_WORD_COUNT * KERNEL_WORD_COUNT;
+
+      uint64_t size = static_cast<uint64_t>(m_Padding) * 2
+        + static_cast<uint64_t>((m_WordCount + KERNEL_WORD_COUNT - 1) / KERNEL_WORD_COUNT * KERNEL_WORD_COUNT);
+      m_Free.assign(size, 0);
+      m_Visited.assign(size, 0);
+      m_Frontier.assign(size, 0);
+      m_Previous.assign(size, 0);
+
+      BuildEdgeMasks();
+    } else {
+      std::fill(m_Visited.begin(), m_Visited.end(), 0);
+      std::fill(m_Frontier.begin(), m_Frontier.end(), 0);
+      std::fill(m_Previous.begin(), m_Previous.end(), 0);
+    }
+
+    const std::vector<uint64_t>& blocked = obstacles.GetWords();
+    for (int32_t i = 0; i < m_WordCount; ++i) {
+      m_Free[m_Padding + i] = ~blocked[i];
+    }
+
+    // Bits past the last cell do not exist
+    uint32_t tailBits = obstacles.GetCellCount() & 63;
+    if (tailBits != 0) {
+      m_Free[m_Padding + m_WordCount - 1] &= (uint64_t(1) << tailBits) - 1;
+    }
+
+    m_Begin = 0;
+    m_End = 0;
+    m_PreviousBegin = 0;
+    m_PreviousEnd = 0;
+    m_Depth = 0;
+  }
+
+  void BitFrontier::Seed(uint32_t index) {
+    if (index >= m_Obstacles->GetCellCount() || !TestBit(m_Free, index)) { return; }
+
+    int32_t word = static_cast<int32_t>(index >> 6);
+    uint64_t bit = uint64_t(1) << (index & 63);
+    m_Frontier[m_Padding + word] |= bit;
+    m_Visited[m_Padding + word] |= bit;
+
+    if (m_Begin == m_End) {
+      m_Begin = word;
+      m_End = word + 1;
+    } else {
+      m_Begin = std::min(m_Begin, word);
+      m_End = std::max(m_End, word + 1);
+    }
+  }
+
+  bool BitFrontier::Expand() {
+    if (m_Begin == m_End) { return false; }
+
+    // The buffer that becomes the next layer still holds the layer before the current one
+    std::fill(m_Previous.begin() + m_Padding + m_PreviousBegin, m_Previous.begin() + m_Padding + m_PreviousEnd, 0);
+    std::swap(m_Previous, m_Frontier);
+    m_PreviousBegin = m_Begin;
+    m_PreviousEnd = m_End;
+
+    // The next layer can only reach as far as the longest shift from the current one
+    int32_t reach = static_cast<int32_t>(m_Obstacles->GetStrideZ() >> 6) + 1;
+    int32_t begin = std::max(m_Begin - reach, 0) / KERNEL_WORD_COUNT * KERNEL_WORD_COUNT;
+    int32_t end = (std::min(m_End + reach, m_WordCount) + KERNEL_WORD_COUNT - 1) / KERNEL_WORD_COUNT * KERNEL_WORD_COUNT;
+
+    const uint64_t* current = m_Previous.data() + m_Padding;
+    std::array<ShiftedSource, DIRECTIONS.size()> sources;
+    for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+      // Every output word combines two neighboring input words, the near one and the one the carry comes from
+      int32_t offset = m_Offsets[i];
+      int32_t wordShift = std::abs(offset) >> 6;
+      sources[i] = ShiftedSource{
+        .nearWords = offset >= 0 ? current - wordShift : current + wordShift,
+        .carryWords = offset >= 0 ? current - wordShift - 1 : current + wordShift + 1,
+        .edgeMask = m_EdgeMasks[i].empty() ? nullptr : m_EdgeMasks[i].data() + m_Padding,
+        .bitShift = std::abs(offset) & 63,
+        .isForward = offset >= 0
+      };
+    }
+
+    std::tie(m_Begin, m_End) = ExpandWords(sources, m_Free.data() + m_Padding, m_Visited.data() + m_Padding,
+                                           m_Frontier.data() + m_Padding, begin, end);
+    if (m_Begin == m_End) { return false; }
+
+    ++m_Depth;
+    return true;
+  }
+
+  uint64_t BitFrontier::CountVisited() const noexcept {
+    uint64_t count = 0;
+    for (int32_t i = 0; i < m_WordCount; ++i) {
+      count += std::popcount(m_Visited[m_Padding + i]);
+    }
+
+    return count;
+  }
+
+  void BitFrontier::BuildEdgeMasks() {
+    // Steps along z leave the volume instead of wrapping, free space already limits them
+    for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+      if (DIRECTIONS[i].z != 0) {
+        m_EdgeMasks[i].clear();
+      } else {
+        m_EdgeMasks[i].assign(m_Free.size(), 0);
+      }
+    }
+
+    // A cell can be entered along a direction unless it lies on the face that direction moves away from
+    uint32_t index = 0;
+    for (int32_t z = 0; z < m_Extent.z; ++z) {
+      for (int32_t y = 0; y < m_Extent.y; ++y) {
+        for (int32_t x = 0; x < m_Extent.x; ++x, ++index) {
+          Coords pos{ x, y, z };
+          uint64_t bit = uint64_t(1) << (index & 63);
+          uint64_t word = static_cast<uint64_t>(m_Padding) + (index >> 6);
+
+          for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+            if (!m_EdgeMasks[i].empty() && m_Obstacles->IsInside(pos - DIRECTIONS[i])) {
+              m_EdgeMasks[i][word] |= bit;
+            }
+          }
+        }
+      }
+    }
+  }
+}
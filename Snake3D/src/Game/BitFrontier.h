@@ -0,0 +1,103 @@
+#pragma once
+
+#include "OccupancyGrid.h"
+
+namespace Snake {
+  // Breadth-first search over a bit-packed grid that expands a whole layer at once.
+  // Every layer shifts the frontier along the six directions, masks it by free space and removes visited cells,
+  // 64 cells per word or 256 cells per step when AVX2 is available.
+  class BitFrontier {
+  public:
+    static constexpr uint8_t NO_MOVE = std::numeric_limits<uint8_t>::max();
+
+    BitFrontier() = default;
+
+    // Captures free space of the grid and clears the search, the grid has to outlive the search
+    void Prepare(const OccupancyGrid& obstacles);
+
+    // Adds a start cell to the current layer, blocked cells are ignored
+    void Seed(uint32_t index);
+
+    // Replaces the frontier with the next layer, returns false once no new cell was reached
+    bool Expand();
+
+    inline bool IsVisited(uint32_t index) const noexcept { return TestBit(m_Visited, index); }
+    inline bool IsInFrontier(uint32_t index) const noexcept { return TestBit(m_Frontier, index); }
+
+    // Calls function(index, move) for every cell of the frontier. The move points to a neighbor in the previous layer,
+    // the step that leads back towards the seeds, and is NO_MOVE for the seeds themselves.
+    template <typename Function>
+    void ForEachFrontierCell(Function&& function) const {
+      for (int32_t word = m_Begin; word < m_End; ++word) {
+        uint64_t remaining = m_Frontier[m_Padding + word];
+        if (remaining == 0) { continue; }
+
+        uint32_t base = static_cast<uint32_t>(word) * 64;
+        for (uint8_t i = 0; i < DIRECTIONS.size() && remaining != 0 && m_Depth != 0; ++i) {
+          // Whole words of cells whose neighbor along direction i belongs to the previous layer
+          uint8_t opposite = GetOppositeDirection(i);
+          uint64_t bits = remaining & GetShiftedWord(m_Previous.data() + m_Padding, m_Offsets[opposite], word);
+          if (!m_EdgeMasks[opposite].empty()) { bits &= m_EdgeMasks[opposite][m_Padding + word]; }
+          remaining &= ~bits;
+
+          for (; bits != 0; bits &= bits - 1) {
+            function(base + static_cast<uint32_t>(std::countr_zero(bits)), i);
+          }
+        }
+
+        for (; remaining != 0; remaining &= remaining - 1) {
+          function(base + static_cast<uint32_t>(std::countr_zero(remaining)), NO_MOVE);
+        }
+      }
+    }
+
+    uint64_t CountVisited() const noexcept;
+
+    inline uint32_t GetDepth() const noexcept { return m_Depth; }
+
+  private:
+    void BuildEdgeMasks();
+
+    // Word of a bitset shifted by offset bits towards higher indices
+    static inline uint64_t GetShiftedWord(const uint64_t* bits, int32_t offset, int32_t word) noexcept {
+      int32_t wordShift = std::abs(offset) >> 6;
+      int32_t bitShift = std::abs(offset) & 63;
+
+      if (offset >= 0) {
+        uint64_t shifted = bits[word - wordShift] << bitShift;
+        return bitShift != 0 ? shifted | (bits[word - wordShift - 1] >> (64 - bitShift)) : shifted;
+      }
+
+      uint64_t shifted = bits[word + wordShift] >> bitShift;
+      return bitShift != 0 ? shifted | (bits[word + wordShift + 1] << (64 - bitShift)) : shifted;
+    }
+
+    inline bool TestBit(const std::vector<uint64_t>& bits, uint32_t index) const noexcept {
+      return (bits[m_Padding + (index >> 6)] >> (index & 63)) & 1;
+    }
+
+  private:
+    const OccupancyGrid* m_Obstacles = nullptr;
+
+    // Bitsets carry zeroed padding on both sides, so shifted loads never leave the buffer
+    int32_t m_Padding = 0;
+    int32_t m_WordCount = 0;
+    Coords m_Extent{ 0, 0, 0 };
+    std::array<int32_t, DIRECTIONS.size()> m_Offsets{};
+
+    std::vector<uint64_t> m_Free;
+    std::vector<uint64_t> m_Visited;
+    std::vector<uint64_t> m_Frontier;
+    std::vector<uint64_t> m_Previous;
+
+    // Cells that may be entered along each direction without wrapping around a row, empty for z steps
+    std::array<std::vector<uint64_t>, DIRECTIONS.size()> m_EdgeMasks;
+
+    // Words of the frontier that can hold set bits
+    int32_t m_Begin = 0;
+    int32_t m_End = 0;
+    int32_t m_PreviousBegin = 0;
+    int32_t m_PreviousEnd = 0;
+    uint32_t m_Depth = 0;
+  };
+}
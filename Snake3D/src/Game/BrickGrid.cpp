@@ -0,0 +1,37 @@
+#include "BrickGrid.h"
+
+namespace Snake {
+  // Maps with more cells than this use 16³ bricks instead of 8³
+  constexpr uint64_t LARGE_BRICK_MIN_CELLS = uint64_t(1) << 24;
+
+  void BrickGrid::Resize(const Coords& mapSize) {
+    m_Extent = Coords{ std::max(mapSize.x, 0), std::max(mapSize.y, 0), std::max(mapSize.z, 0) };
+    uint64_t cellCount = static_cast<uint64_t>(m_Extent.x) * static_cast<uint64_t>(m_Extent.y) * static_cast<uint64_t>(m_Extent.z);
+
+    m_BrickShift = cellCount > LARGE_BRICK_MIN_CELLS ? 4 : 3;
+
+    uint32_t brickSize = GetBrickSize();
+    uint32_t bricksX = (static_cast<uint32_t>(m_Extent.x) + brickSize - 1) >> m_BrickShift;
+    uint32_t bricksY = (static_cast<uint32_t>(m_Extent.y) + brickSize - 1) >> m_BrickShift;
+    uint32_t bricksZ = (static_cast<uint32_t>(m_Extent.z) + brickSize - 1) >> m_BrickShift;
+    m_BrickStrideY = bricksX;
+    m_BrickStrideZ = bricksX * bricksY;
+
+    m_BlockedCounts.assign(static_cast<uint64_t>(m_BrickStrideZ) * bricksZ, 0);
+  }
+
+  void BrickGrid::Clear() noexcept {
+    std::fill(m_BlockedCounts.begin(), m_BlockedCounts.end(), 0);
+  }
+
+  void BrickGrid::Build(const OccupancyGrid& grid) {
+    Clear();
+
+    const std::vector<uint64_t>& words = grid.GetWords();
+    for (uint64_t i = 0; i < words.size(); ++i) {
+      for (uint64_t word = words[i]; word != 0; word &= word - 1) {
+        AddBlocked(grid.GetCoords(static_cast<uint32_t>(i * 64 + std::countr_zero(word))));
+      }
+    }
+  }
+}
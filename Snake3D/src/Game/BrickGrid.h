@@ -0,0 +1,65 @@
+#pragma once
+
+#include "pch.h"
+
+#include "OccupancyGrid.h"
+
+namespace Snake {
+  // Blocked cell counts of the cubic bricks of an OccupancyGrid. The cells themselves stay in the dense grid, the counts
+  // only tell whether a whole brick is empty, so searches can step over open space and the planner can judge how
+  // cluttered an area is. Two bytes per brick, next to the 64 bytes the dense grid spends on an 8³ brick.
+  class BrickGrid {
+  public:
+    BrickGrid() = default;
+    explicit BrickGrid(const Coords& mapSize) { Resize(mapSize); }
+
+    // Resizes the grid to the given map size and clears every brick. Large maps get larger bricks to keep the brick table small.
+    void Resize(const Coords& mapSize);
+    void Clear() noexcept;
+
+    // Counts every blocked cell of the grid, which has to be of the same size
+    void Build(const OccupancyGrid& grid);
+
+    // The cell at the position became blocked or free, the caller only reports actual changes
+    inline void AddBlocked(const Coords& pos) noexcept { ++m_BlockedCounts[GetBrickIndex(pos)]; }
+    inline void RemoveBlocked(const Coords& pos) noexcept { --m_BlockedCounts[GetBrickIndex(pos)]; }
+
+    inline bool IsInside(const Coords& pos) const noexcept {
+      return static_cast<uint32_t>(pos.x) < static_cast<uint32_t>(m_Extent.x)
+        && static_cast<uint32_t>(pos.y) < static_cast<uint32_t>(m_Extent.y)
+        && static_cast<uint32_t>(pos.z) < static_cast<uint32_t>(m_Extent.z);
+    }
+
+    // Bricks are indexed x-fastest like cells, the position has to be inside the map
+    inline uint32_t GetBrickIndex(const Coords& pos) const noexcept {
+      return (static_cast<uint32_t>(pos.x) >> m_BrickShift)
+        + (static_cast<uint32_t>(pos.y) >> m_BrickShift) * m_BrickStrideY
+        + (static_cast<uint32_t>(pos.z) >> m_BrickShift) * m_BrickStrideZ;
+    }
+
+    inline bool IsBrickEmpty(uint32_t brickIndex) const noexcept { return m_BlockedCounts[brickIndex] == 0; }
+
+    // Outside of the map counts as blocked
+    inline bool IsBrickEmpty(const Coords& pos) const noexcept { return IsInside(pos) && IsBrickEmpty(GetBrickIndex(pos)); }
+
+    // Lowest corner of the brick holding the position
+    inline Coords GetBrickOrigin(const Coords& pos) const noexcept {
+      int32_t mask = ~static_cast<int32_t>(GetBrickSize() - 1);
+      return Coords{ pos.x & mask, pos.y & mask, pos.z & mask };
+    }
+
+    inline uint32_t GetBrickSize() const noexcept { return 1u << m_BrickShift; }
+    inline uint32_t GetBrickCount() const noexcept { return static_cast<uint32_t>(m_BlockedCounts.size()); }
+
+    inline const Coords& GetExtent() const noexcept { return m_Extent; }
+
+  private:
+    Coords m_Extent{ 0, 0, 0 };
+
+    uint32_t m_BrickShift = 3;
+    uint32_t m_BrickStrideY = 0;
+    uint32_t m_BrickStrideZ = 0;
+
+    std::vector<uint16_t> m_BlockedCounts;
+  };
+}
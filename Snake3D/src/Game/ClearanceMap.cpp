@@ -0,0 +1,16 @@
+#include "ClearanceMap.h"
+
+namespace Snake {
+  void ClearanceMap::Resize(uint32_t cellCount) {
+    m_ClearTicks.assign(cellCount, NEVER);
+    m_MarkedCells.clear();
+  }
+
+  void ClearanceMap::Reset() noexcept {
+    for (uint32_t index : m_MarkedCells) {
+      m_ClearTicks[index] = NEVER;
+    }
+
+    m_MarkedCells.clear();
+  }
+}
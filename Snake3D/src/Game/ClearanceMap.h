@@ -0,0 +1,40 @@
+#pragma once
+
+#include "OccupancyGrid.h"
+
+namespace Snake {
+  // Number of ticks after which each blocked cell becomes free, one byte per cell.
+  // Snake bodies clear from the tail, so a segment clears about as many ticks later as it is away from the tail.
+  // Fences and cells that never had a body are reported as never clearing.
+  class ClearanceMap {
+  public:
+    static constexpr uint8_t NEVER = std::numeric_limits<uint8_t>::max();
+
+    ClearanceMap() = default;
+
+    // Resizes the map to the given cell count and marks every cell as never clearing
+    void Resize(uint32_t cellCount);
+
+    // Forgets the bodies of the previous tick, only the cells written since the last call are touched
+    void Reset() noexcept;
+
+    // Keeps the latest clear tick when several snakes claim the same cell
+    inline void Mark(uint32_t index, uint8_t clearTick) noexcept {
+      if (m_ClearTicks[index] == NEVER) {
+        m_ClearTicks[index] = clearTick;
+        m_MarkedCells.push_back(index);
+      } else {
+        m_ClearTicks[index] = std::max(m_ClearTicks[index], clearTick);
+      }
+    }
+
+    inline uint8_t GetClearTick(uint32_t index) const noexcept { return m_ClearTicks[index]; }
+
+    // Only meaningful for cells that are blocked now, free cells are not tracked
+    inline bool IsClearAt(uint32_t index, uint32_t tick) const noexcept { return m_ClearTicks[index] <= tick; }
+
+  private:
+    std::vector<uint8_t> m_ClearTicks;
+    std::vector<uint32_t> m_MarkedCells;
+  };
+}
@@ -0,0 +1,36 @@
+#include "DangerField.h"
+
+namespace Snake {
+  void DangerField::Build(const OccupancyGrid& staticObstacles, const std::vector<EnemySnake>& enemies, uint32_t radius) {
+    uint32_t cellCount = staticObstacles.GetCellCount();
+    if (m_EnemyTicks.size() != cellCount) {
+      m_EnemyTicks.assign(cellCount, SAFE);
+    } else {
+      for (uint32_t index : m_ReachedCells) {
+        m_EnemyTicks[index] = SAFE;
+      }
+    }
+
+    m_ReachedCells.clear();
+    m_Frontier.Prepare(staticObstacles);
+
+    for (const EnemySnake& enemy : enemies) {
+      if (enemy.status != SnakeStatus::Alive || enemy.geometry.empty() || staticObstacles.IsBlocked(enemy.geometry.front())) { continue; }
+
+      uint32_t index = staticObstacles.GetIndex(enemy.geometry.front());
+      if (m_EnemyTicks[index] == SAFE) { m_ReachedCells.push_back(index); }
+
+      m_EnemyTicks[index] = 0;
+      m_Frontier.Seed(index);
+    }
+
+    radius = std::min<uint32_t>(radius, SAFE - 1);
+    while (m_Frontier.GetDepth() < radius && m_Frontier.Expand()) {
+      uint8_t tick = static_cast<uint8_t>(m_Frontier.GetDepth());
+      m_Frontier.ForEachFrontierCell([this, tick](uint32_t index, uint8_t) {
+        m_EnemyTicks[index] = tick;
+        m_ReachedCells.push_back(index);
+      });
+    }
+  }
+}
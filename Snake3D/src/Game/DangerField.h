@@ -0,0 +1,28 @@
+#pragma once
+
+#include "OccupancyGrid.h"
+#include "BitFrontier.h"
+
+namespace Snake {
+  // Earliest tick at which any alive enemy head could enter each cell, computed with one bounded bit-parallel
+  // multi-source BFS per tick. Cells beyond the radius are reported as SAFE, only the cells reached are reset.
+  class DangerField {
+  public:
+    static constexpr uint8_t SAFE = std::numeric_limits<uint8_t>::max();
+
+    DangerField() = default;
+
+    // Expands at most radius layers from the enemy heads over the static obstacles
+    void Build(const OccupancyGrid& staticObstacles, const std::vector<EnemySnake>& enemies, uint32_t radius);
+
+    inline uint8_t GetEnemyTick(uint32_t index) const noexcept { return m_EnemyTicks[index]; }
+
+    // True when an enemy head could be on the cell no later than we arrive there
+    inline bool IsContested(uint32_t index, uint32_t arrivalTick) const noexcept { return m_EnemyTicks[index] <= arrivalTick; }
+
+  private:
+    std::vector<uint8_t> m_EnemyTicks;
+    std::vector<uint32_t> m_ReachedCells;
+    BitFrontier m_Frontier;
+  };
+}
@@ -0,0 +1,73 @@
+#include "FoodDistanceField.h"
+
+namespace Snake {
+  void FoodDistanceField::Build(const OccupancyGrid& staticObstacles, const FoodIndex& foodIndex) {
+    m_Obstacles = &staticObstacles;
+
+    uint32_t cellCount = staticObstacles.GetCellCount();
+    m_Distances.assign(cellCount, UNREACHABLE);
+    m_Moves.assign(cellCount, NO_MOVE);
+    m_Frontier.Prepare(staticObstacles);
+
+    for (const FoodIndex::Entry& food : foodIndex.GetEntries()) {
+      AddSource(food.coords);
+    }
+
+    // Whole layers are expanded at once, only the cells they reached are written out
+    while (m_Frontier.GetDepth() + 1 < UNREACHABLE && m_Frontier.Expand()) {
+      uint16_t distance = static_cast<uint16_t>(m_Frontier.GetDepth());
+      m_Frontier.ForEachFrontierCell([this, distance](uint32_t index, uint8_t move) {
+        m_Distances[index] = distance;
+        m_Moves[index] = move;
+      });
+    }
+  }
+
+  uint8_t FoodDistanceField::FindDescentMove(const Coords& position, const OccupancyGrid& obstacles, uint32_t horizon) const {
+    if (m_Obstacles == nullptr || m_Distances.empty()) { return NO_MOVE; }
+
+    std::array<std::pair<uint16_t, uint8_t>, DIRECTIONS.size()> candidates;
+    uint32_t candidateCount = 0;
+
+    for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+      Coords newPos = position + DIRECTIONS[i];
+      if (obstacles.IsBlocked(newPos)) { continue; }
+
+      uint16_t distance = m_Distances[m_Obstacles->GetIndex(newPos)];
+      if (distance == UNREACHABLE) { continue; }
+
+      candidates[candidateCount++] = { distance, i };
+    }
+
+    std::sort(candidates.begin(), candidates.begin() + candidateCount);
+
+    for (uint32_t i = 0; i < candidateCount; ++i) {
+      uint8_t move = candidates[i].second;
+      if (IsDescentClear(m_Obstacles->GetIndex(position + DIRECTIONS[move]), obstacles, horizon)) {
+        return move;
+      }
+    }
+
+    return NO_MOVE;
+  }
+
+  void FoodDistanceField::AddSource(const Coords& position) {
+    if (m_Obstacles->IsBlocked(position)) { return; }
+
+    uint32_t index = m_Obstacles->GetIndex(position);
+    m_Distances[index] = 0;
+    m_Frontier.Seed(index);
+  }
+
+  bool FoodDistanceField::IsDescentClear(uint32_t index, const OccupancyGrid& obstacles, uint32_t horizon) const {
+    for (uint32_t step = 0; step < horizon; ++step) {
+      uint8_t move = m_Moves[index];
+      if (move == NO_MOVE) { return true; }
+
+      index = m_Obstacles->GetNeighborIndex(index, move);
+      if (obstacles.Test(index)) { return false; }
+    }
+
+    return true;
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "OccupancyGrid.h"
+#include "FoodIndex.h"
+#include "BitFrontier.h"
+
+namespace Snake {
+  // Distance from every cell to the closest food, computed with a single bit-parallel multi-source BFS per tick.
+  // Each reached cell also stores the direction of its next step towards that food.
+  class FoodDistanceField {
+  public:
+    static constexpr uint16_t UNREACHABLE = std::numeric_limits<uint16_t>::max();
+    static constexpr uint8_t NO_MOVE = std::numeric_limits<uint8_t>::max();
+
+    FoodDistanceField() = default;
+
+    // Seeds the search from regular, golden and suspicious food and expands over the static obstacles
+    void Build(const OccupancyGrid& staticObstacles, const FoodIndex& foodIndex);
+
+    // Picks the neighbor of the position with the lowest distance whose descent is not blocked by the current obstacles.
+    // Returns NO_MOVE when every descent is blocked within the horizon and a local search is required.
+    uint8_t FindDescentMove(const Coords& position, const OccupancyGrid& obstacles, uint32_t horizon) const;
+
+    inline uint16_t GetDistance(uint32_t index) const noexcept { return m_Distances[index]; }
+    inline uint8_t GetMove(uint32_t index) const noexcept { return m_Moves[index]; }
+
+    inline const OccupancyGrid& GetObstacles() const noexcept { return *m_Obstacles; }
+
+  private:
+    void AddSource(const Coords& position);
+
+    bool IsDescentClear(uint32_t index, const OccupancyGrid& obstacles, uint32_t horizon) const;
+
+  private:
+    const OccupancyGrid* m_Obstacles = nullptr;
+
+    std::vector<uint16_t> m_Distances;
+    std::vector<uint8_t> m_Moves;
+    BitFrontier m_Frontier;
+  };
+}
@@ -0,0 +1,77 @@
+#include "FoodIndex.h"
+
+namespace Snake {
+  void FoodIndex::Build(const std::vector<Food>& foods, const SpecialFood& specialFood) {
+    Prepare(foods.size() + specialFood.golden.size() + specialFood.suspicious.size());
+
+    for (const Food& food : foods) {
+      Entry& entry = Insert(food.coords);
+      entry.points = static_cast<int32_t>(food.points);
+      entry.type = food.type;
+    }
+
+    // Special food usually duplicates a regular entry, in which case only its kind is updated
+    for (const Coords& golden : specialFood.golden) {
+      Insert(golden).kind = FoodKind::Golden;
+    }
+
+    for (const Coords& suspicious : specialFood.suspicious) {
+      Insert(suspicious).kind = FoodKind::Suspicious;
+    }
+  }
+
+  void FoodIndex::Build(const WorldSnapshot& snapshot) {
+    std::span<const uint32_t> foods = snapshot.GetFood();
+    std::span<const uint32_t> golden = snapshot.GetGoldenFood();
+    std::span<const uint32_t> suspicious = snapshot.GetSuspiciousFood();
+    Prepare(foods.size() + golden.size() + suspicious.size());
+
+    for (uint64_t i = 0; i < foods.size(); ++i) {
+      if (!snapshot.IsValidCell(foods[i])) { continue; }
+
+      Entry& entry = Insert(snapshot.GetCoords(foods[i]));
+      entry.points = static_cast<int32_t>(snapshot.GetFoodPoints()[i]);
+      entry.type = snapshot.GetFoodTypes()[i];
+    }
+
+    for (uint32_t cell : golden) {
+      if (snapshot.IsValidCell(cell)) { Insert(snapshot.GetCoords(cell)).kind = FoodKind::Golden; }
+    }
+
+    for (uint32_t cell : suspicious) {
+      if (snapshot.IsValidCell(cell)) { Insert(snapshot.GetCoords(cell)).kind = FoodKind::Suspicious; }
+    }
+  }
+
+  void FoodIndex::Clear() noexcept {
+    std::fill(m_Slots.begin(), m_Slots.end(), Slot{});
+    m_Entries.clear();
+  }
+
+  void FoodIndex::Prepare(uint64_t count) {
+    Clear();
+    if (count == 0) { return; }
+
+    // Keep the load factor at or below one half
+    uint64_t capacity = std::bit_ceil(count * 2);
+    if (m_Slots.size() < capacity) {
+      m_Slots.resize(capacity);
+    }
+    m_Mask = m_Slots.size() - 1;
+    m_Entries.reserve(count);
+  }
+
+  FoodIndex::Entry& FoodIndex::Insert(const Coords& coords) {
+    uint64_t key = PackCoords(coords);
+    for (uint64_t slot = Hash(key) & m_Mask;; slot = (slot + 1) & m_Mask) {
+      Slot& current = m_Slots[slot];
+      if (current.entry == EMPTY_SLOT) {
+        current.key = key;
+        current.entry = static_cast<uint32_t>(m_Entries.size());
+        return m_Entries.emplace_back(Entry{ .coords = coords });
+      }
+
+      if (current.key == key) { return m_Entries[current.entry]; }
+    }
+  }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "pch.h"
+
+#include "WorldSnapshot.h"
+
+namespace Snake {
+  enum class FoodKind : uint8_t {
+    Regular, Golden, Suspicious
+  };
+
+  // Per-tick open-addressing table of food keyed by packed coordinates.
+  // Entries are also kept densely so they can be iterated without touching the table.
+  class FoodIndex {
+  public:
+    struct Entry {
+      Coords coords{ 0, 0, 0 };
+      int32_t points = 0;
+      uint32_t type = 0;
+      FoodKind kind = FoodKind::Regular;
+    };
+
+    FoodIndex() = default;
+
+    void Build(const std::vector<Food>& foods, const SpecialFood& specialFood);
+    void Build(const WorldSnapshot& snapshot);
+    void Clear() noexcept;
+
+    inline const Entry* Find(const Coords& coords) const noexcept {
+      if (m_Entries.empty()) { return nullptr; }
+
+      uint64_t key = PackCoords(coords);
+      for (uint64_t slot = Hash(key) & m_Mask;; slot = (slot + 1) & m_Mask) {
+        const Slot& current = m_Slots[slot];
+        if (current.entry == EMPTY_SLOT) { return nullptr; }
+        if (current.key == key) { return &m_Entries[current.entry]; }
+      }
+    }
+
+    inline bool Contains(const Coords& coords) const noexcept { return Find(coords) != nullptr; }
+
+    inline bool IsEmpty() const noexcept { return m_Entries.empty(); }
+    inline uint64_t GetSize() const noexcept { return m_Entries.size(); }
+    inline const std::vector<Entry>& GetEntries() const noexcept { return m_Entries; }
+
+  private:
+    static constexpr uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+      uint64_t key = 0;
+      uint32_t entry = EMPTY_SLOT;
+    };
+
+    // Sizes the table for the given number of entries and clears it
+    void Prepare(uint64_t count);
+    Entry& Insert(const Coords& coords);
+
+    static inline uint64_t PackCoords(const Coords& coords) noexcept {
+      return (static_cast<uint64_t>(static_cast<uint32_t>(coords.x)) & 0x1FFFFF)
+        | ((static_cast<uint64_t>(static_cast<uint32_t>(coords.y)) & 0x1FFFFF) << 21)
+        | ((static_cast<uint64_t>(static_cast<uint32_t>(coords.z)) & 0x1FFFFF) << 42);
+    }
+
+    static inline uint64_t Hash(uint64_t key) noexcept {
+      return (key * 0x9E3779B97F4A7C15ull) >> 32;
+    }
+
+  private:
+    std::vector<Slot> m_Slots;
+    std::vector<Entry> m_Entries;
+    uint64_t m_Mask = 0;
+  };
+}
@@ -3,11 +3,101 @@
 #include "Application.h"
 
 namespace Snake {
-  constexpr std::array<Coords, 6> DIRECTIONS = {
-    Coords{ 1, 0, 0 }, Coords{ -1, 0, 0 },
-    Coords{ 0, 1, 0 }, Coords{ 0, -1, 0 },
-    Coords{ 0, 0, 1 }, Coords{ 0, 0, -1 }
-  };
+  // How far a snake follows the shared food field before trusting it without a local search
+  constexpr uint32_t FIELD_REPAIR_HORIZON = SECTOR_SIZE;
+
+  // Food value multipliers used when ranking targets
+  constexpr float GOLDEN_FOOD_WEIGHT = 2.0f;
+  constexpr float SUSPICIOUS_FOOD_WEIGHT = 0.25f;
+
+  // Number of best ranked food items verified with A* per snake
+  constexpr uint32_t PLANNER_CANDIDATE_COUNT = 4;
+
+  // Upper bound on expanded cells per A* search, keeps planning inside the tick on full-size maps
+  constexpr uint32_t PLANNER_EXPANSION_LIMIT = 50000;
+
+  // A detour around a blocked stretch of a kept plan that needs more expansions is not worth it, the plan is dropped
+  constexpr uint32_t REPAIR_EXPANSION_LIMIT = PLANNER_EXPANSION_LIMIT / 16;
+
+  // Blocked stretches repaired per tick before the plan is dropped
+  constexpr uint32_t MAX_PLAN_REPAIRS = 4;
+
+  // Enemy heads are predicted this many ticks ahead, further out their moves are too uncertain to be worth a cost
+  constexpr uint32_t DANGER_RADIUS = 5;
+
+  // Extra cost of a cell an enemy head can reach no later than we do, halved for every tick the enemy needs
+  constexpr uint32_t DANGER_PENALTY = 32;
+
+  // Slightly inflated heuristic, breaks f-score ties towards cells closer to the goal
+  constexpr float HEURISTIC_WEIGHT = 1.001f;
+
+  // Time kept in reserve after planning for serializing and sending the moves
+  constexpr double DEADLINE_SAFETY_MARGIN_MS = 5.0;
+
+  // Searches look at the clock once per this many expanded cells
+  constexpr uint32_t DEADLINE_CHECK_INTERVAL = 1024;
+
+  // Returned by Game::Jump when the deadline passed during the walk, no jump is ever that long
+  constexpr uint32_t JUMP_CUT_SHORT = std::numeric_limits<uint32_t>::max();
+
+  // Rollouts stop after this long even when the tick has more time left, so they never hold back sending the moves
+  constexpr double ROLLOUT_TIME_LIMIT_MS = 40.0;
+
+  // Share of the time left that rollouts may take while the moves of the current tick wait for them
+  constexpr double SENDING_ROLLOUT_SHARE = 0.25;
+
+  static inline float GetFoodValue(const FoodIndex::Entry& food) noexcept {
+    switch (food.kind) {
+      case FoodKind::Golden: return static_cast<float>(food.points) * GOLDEN_FOOD_WEIGHT;
+      case FoodKind::Suspicious: return static_cast<float>(food.points) * SUSPICIOUS_FOOD_WEIGHT;
+      default: return static_cast<float>(food.points);
+    }
+  }
+
+  static inline float GetPathScore(uint32_t cost, const Coords& pos, const Coords& goal) noexcept {
+    return static_cast<float>(cost) + static_cast<float>(GetManhattanDistance(pos, goal)) * HEURISTIC_WEIGHT;
+  }
+
+  static inline uint32_t GetDangerPenalty(const DangerField& danger, uint32_t index, uint32_t arrivalTick) noexcept {
+    uint8_t enemyTick = std::max<uint8_t>(danger.GetEnemyTick(index), 1);
+    return enemyTick <= arrivalTick ? DANGER_PENALTY >> (enemyTick - 1) : 0;
+  }
+
+  // DIRECTIONS come in pairs along x, y and z
+  static inline uint8_t GetAxis(uint8_t direction) noexcept { return direction >> 1; }
+
+  static inline int32_t GetCoordinate(const Coords& pos, uint8_t axis) noexcept {
+    return axis == 0 ? pos.x : (axis == 1 ? pos.y : pos.z);
+  }
+
+  static inline bool IsJumpBlocked(const Coords& pos, const Coords& start, const DangerField& danger, const OccupancyGrid& obstacles) noexcept {
+    return obstacles.IsBlocked(pos) || (GetManhattanDistance(pos, start) == 1 && danger.IsContested(obstacles.GetIndex(pos), 1));
+  }
+
+  // A cell entered along some axis needs to turn back to an earlier axis when the cell beside its predecessor is blocked
+  static inline bool IsForcedNeighbor(const Coords& pos, uint8_t direction, uint8_t turn, const Coords& start, const DangerField& danger,
+                                      const OccupancyGrid& obstacles) noexcept {
+    Coords previous = pos - DIRECTIONS[direction];
+    return IsJumpBlocked(previous + DIRECTIONS[turn], start, danger, obstacles) && !IsJumpBlocked(pos + DIRECTIONS[turn], start, danger, obstacles);
+  }
+
+  static inline uint8_t GetMoveTowards(const Coords& from, const Coords& to) noexcept {
+    for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+      if (from + DIRECTIONS[i] == to) { return i; }
+    }
+
+    return SearchScratch::NO_MOVE;
+  }
+
+  Game::Game() {
+    ConfigureWorkers(0);
+  }
+
+  void Game::ConfigureWorkers(uint32_t workerCount, bool pinWorkers) {
+    m_ThreadPool = std::make_unique<Utils::ThreadPool>(workerCount, pinWorkers);
+    m_Arenas.resize(m_ThreadPool->GetSlotCount());
+    CORE_INFO("Planner uses {} workers", m_ThreadPool->GetWorkerCount());
+  }
 
   void Game::Update(const GameState& gameState) {
     Utils::Timer timer;
@@ -15,137 +105,803 @@ namespace Snake {
 
     Application& app = Application::Get();
 
-    m_Snakes.snakesData.resize(gameState.snakes.size());
+    // The answer planned while waiting is sent as is when the tick went as predicted
+    ++m_ReceivedTicks;
+    if (IsSpeculationValid(gameState)) {
+      ++m_SpeculationHits;
+      m_Snakes.snakesData.swap(m_Speculation.snakes.snakesData);
+      m_Json.swap(m_Speculation.json);
+      m_Speculation.isReady = false;
 
-    // Pre-compute obstacles for all snakes
-    std::unordered_set<Coords, CoordsHash> globalObstacles;
-    for (const Coords& fence : gameState.fences) {
-      globalObstacles.insert(fence);
+      app.SendJsonToServer(m_Json);
+      timer.Stop();
+      CORE_INFO("Game::Update sent the speculative plan after {} ms ({} of {} ticks so far)", timer.GetElapsedMilliSec(),
+                m_SpeculationHits, m_ReceivedTicks);
+      return;
     }
 
-    // Add enemy snake bodies to obstacles
-    for (const EnemySnake& enemy : gameState.enemies) {
-      if (enemy.status == "alive") {
-        for (const Coords& pos : enemy.geometry) {
-          globalObstacles.insert(pos);
+    m_Speculation.isReady = false;
+
+    // Moves have to reach the server before the tick ends, which costs one more round trip
+    double budgetMs = static_cast<double>(gameState.tickRemainMs) - app.GetServer().GetRoundTripMs() - DEADLINE_SAFETY_MARGIN_MS;
+    if (!Plan(gameState, Utils::Deadline::FromNow(std::chrono::duration<double, std::milli>(std::max(budgetMs, 0.0))), false)) { return; }
+
+    app.SendJsonToServer(m_Json);
+    timer.Stop();
+    CORE_INFO("Game::Update took {} ms", timer.GetElapsedMilliSec());
+  }
+
+  void Game::Speculate(const GameState& gameState, const Utils::Deadline& deadline) {
+    if (deadline.GetRemainingMilliSec() <= DEADLINE_SAFETY_MARGIN_MS) { return; }
+
+    Utils::Timer timer;
+    timer.Start();
+
+    PredictNextState(gameState, m_Speculation.state);
+    if (!Plan(m_Speculation.state, deadline, true)) { return; }
+
+    m_Speculation.snakes.snakesData.swap(m_Snakes.snakesData);
+    m_Speculation.json.swap(m_Json);
+    m_Speculation.isReady = true;
+
+    timer.Stop();
+    CORE_INFO("Game::Speculate planned turn {} in {} ms", m_Speculation.state.turn, timer.GetElapsedMilliSec());
+  }
+
+  bool Game::Plan(const GameState& gameState, const Utils::Deadline& deadline, bool isSpeculative) {
+    Application& app = Application::Get();
+
+    m_Snakes.snakesData.resize(gameState.snakes.size());
+    m_SnakeSlots.resize(gameState.snakes.size());
+
+    // Only the cells that moved since the previous tick are touched
+    m_World.Update(gameState);
+    m_Regions.Update(m_World);
+
+    // Sector caches only follow the fences, so they are rebuilt once per round
+    m_Sectors.Update(m_World.GetStaticLayer());
+    const std::vector<uint32_t>& dirtySectors = m_Sectors.GetDirtySectors();
+    m_ThreadPool->ParallelFor(static_cast<uint32_t>(dirtySectors.size()), [this, &dirtySectors](uint32_t index, uint32_t slot) {
+      m_Sectors.RebuildSector(dirtySectors[index], m_Arenas[slot].scratch);
+    });
+
+    m_FoodIndex.Build(gameState.food, gameState.specialFood);
+
+    // The shared fields are independent sweeps over their own buffers, each one runs on its own worker
+    m_ThreadPool->ParallelFor(3, [this, &gameState](uint32_t index, uint32_t) {
+      switch (index) {
+        // One sweep from every food serves all snakes
+        case 0: m_FoodField.Build(m_World.GetStaticLayer(), m_FoodIndex); break;
+
+        // Enemy head reach is likewise shared, snakes only read it as a cost
+        case 1: m_Danger.Build(m_World.GetStaticLayer(), gameState.enemies, DANGER_RADIUS); break;
+
+        // Which head reaches each cell first, food owned by another snake is not worth a search
+        default: m_Territory.Build(m_World.GetObstacles(), gameState.snakes, gameState.enemies); break;
+      }
+    });
+
+    TickContext context{
+      m_World.GetObstacles(), m_World.GetBricks(), m_World.GetClearance(), m_Danger, m_Regions, m_Territory, m_FoodIndex, m_FoodField, deadline
+    };
+
+    // Slots left idle by the snakes are used to search food candidates in parallel
+    m_SplitSearches = gameState.snakes.size() < m_ThreadPool->GetSlotCount();
+    if (m_SplitSearches) {
+      // Every snake may split while the ones before it wait on the same slot
+      uint64_t candidateBuffers = gameState.snakes.size() * PLANNER_CANDIDATE_COUNT;
+      for (WorkerArena& arena : m_Arenas) {
+        if (arena.candidateCells.size() < candidateBuffers) {
+          arena.candidateCells.resize(candidateBuffers);
         }
-        AddSurroundingCellsAsObstacles(enemy.geometry.front(), globalObstacles, gameState.mapSize);
       }
     }
 
+    for (const PlayerSnake& snake : gameState.snakes) {
+      if (snake.key >= m_Plans.size()) { m_Plans.resize(snake.key + 1); }
+    }
+
+    for (uint64_t i = 0; i < gameState.snakes.size(); ++i) {
+      SnakePlan& plan = m_Plans[gameState.snakes[i].key];
+      plan.lastTurn = gameState.turn;
+      m_SnakeSlots[i].plan = &plan;
+    }
+
+    // Plans of snakes that are gone are dropped, their buffers stay for reuse
+    for (SnakePlan& plan : m_Plans) {
+      if (plan.lastTurn != gameState.turn) { plan.isValid = false; }
+    }
+
     // Process all snakes in parallel
-    std::for_each(std::execution::par_unseq, gameState.snakes.begin(), gameState.snakes.end(), [this, &gameState, &globalObstacles](const PlayerSnake& snake) {
-      uint64_t index = std::distance(&gameState.snakes.front(), &snake);
-      ProcessSnake(snake, gameState, globalObstacles, m_Snakes.snakesData[index]);
+    m_ThreadPool->ParallelFor(static_cast<uint32_t>(gameState.snakes.size()), [this, &gameState, &context](uint32_t index, uint32_t slot) {
+      SnakeSlot& snakeSlot = m_SnakeSlots[index];
+      snakeSlot.wasCutShort = ProcessSnake(gameState.snakes[index], index, context, m_Arenas[slot].scratch, *snakeSlot.plan,
+                                           snakeSlot.data);
     });
 
+    // Short simulations against random enemy moves catch planned moves that walk into a fight the planner cannot see
+    uint32_t tickRate = app.GetServerTickRate();
+    m_Simulator.Load(gameState, tickRate == 0 ? 1000 : 1000 / tickRate);
+    m_PlannedMoves.resize(gameState.snakes.size());
+    for (uint64_t i = 0; i < gameState.snakes.size(); ++i) {
+      bool isAlive = gameState.snakes[i].status == SnakeStatus::Alive;
+      m_PlannedMoves[i] = isAlive ? GetMoveTowards(Coords{ 0, 0, 0 }, m_SnakeSlots[i].data.direction) : Simulator::NO_MOVE;
+    }
+
+    double rolloutMs = ROLLOUT_TIME_LIMIT_MS;
+    if (!isSpeculative) {
+      rolloutMs = std::min(rolloutMs, std::max(context.deadline.GetRemainingMilliSec(), 0.0) * SENDING_ROLLOUT_SHARE);
+    }
+
+    Utils::Deadline rolloutLimit = Utils::Deadline::FromNow(std::chrono::duration<double, std::milli>(rolloutMs));
+    Utils::Deadline rolloutDeadline(std::min(context.deadline.GetTimePoint(), rolloutLimit.GetTimePoint()));
+    m_Rollouts.Evaluate(m_Simulator, m_PlannedMoves, *m_ThreadPool, rolloutDeadline);
+
+    for (uint64_t i = 0; i < gameState.snakes.size(); ++i) {
+      if (m_PlannedMoves[i] == Simulator::NO_MOVE) { continue; }
+
+      uint8_t move = m_Rollouts.ChooseMove(static_cast<uint32_t>(i), m_PlannedMoves[i]);
+      m_SnakeSlots[i].data.direction = DIRECTIONS[move];
+    }
+
+    CORE_INFO("{} rollouts, {:.0f} per second", m_Rollouts.GetRolloutCount(), m_Rollouts.GetRolloutsPerSecond());
+
+    uint32_t cutShortCount = 0;
+    for (uint64_t i = 0; i < m_SnakeSlots.size(); ++i) {
+      m_Snakes.snakesData[i] = m_SnakeSlots[i].data;
+      cutShortCount += m_SnakeSlots[i].wasCutShort;
+    }
+
+    ++m_PlannedTicks;
+    if (cutShortCount > 0) {
+      ++m_CutShortTicks;
+      CORE_WARN("Deadline cut planning short for {} snakes ({} of {} ticks so far)", cutShortCount, m_CutShortTicks, m_PlannedTicks);
+    }
+
     glz::error_ctx err = glz::write_json(m_Snakes, m_Json);
     if (err) {
       CORE_ASSERT(false, "Failed to update game: Failed to write json: {}!", glz::format_error(err, m_Json));
-      return;
+      return false;
     }
 
-    app.SendJsonToServer(m_Json);
-    timer.Stop();
-    CORE_INFO("Game::Update took {} ms", timer.GetElapsedMilliSec());
+    return true;
+  }
+
+  void Game::PredictNextState(const GameState& gameState, GameState& predicted) {
+    uint32_t tickRate = Application::Get().GetServerTickRate();
+    m_Simulator.Load(gameState, tickRate == 0 ? 1000 : 1000 / tickRate);
+
+    // Our snakes take the moves just sent, enemies keep going straight and only turn when they have to
+    SimState& state = m_PredictionState;
+    state.CopyFrom(m_Simulator.GetInitialState());
+    m_PlannedMoves.resize(state.GetSnakeCount());
+    for (uint32_t i = 0; i < state.GetSnakeCount(); ++i) {
+      const SimState::SnakeState& snake = state.GetSnake(i);
+      if (i < gameState.snakes.size()) {
+        m_PlannedMoves[i] = i < m_Snakes.snakesData.size() ? GetMoveTowards(Coords{ 0, 0, 0 }, m_Snakes.snakesData[i].direction) : Simulator::NO_MOVE;
+        continue;
+      }
+
+      m_PlannedMoves[i] = Simulator::NO_MOVE;
+      for (uint8_t k = 0; k < DIRECTIONS.size() && snake.isAlive; ++k) {
+        uint8_t move = static_cast<uint8_t>((snake.direction + k) % DIRECTIONS.size());
+        if (m_Simulator.IsMoveSafe(state, i, move)) {
+          m_PlannedMoves[i] = move;
+          break;
+        }
+      }
+    }
+
+    m_Simulator.Step(state, m_PlannedMoves.data());
+
+    // Copy assignment keeps the buffers of the previous prediction
+    predicted = gameState;
+    predicted.turn = gameState.turn + 1;
+
+    const OccupancyGrid& grid = m_Simulator.GetFences();
+    auto readBody = [&state, &grid](uint32_t index, std::vector<Coords>& geometry, SnakeStatus& status) {
+      const SimState::SnakeState& snake = state.GetSnake(index);
+      geometry.resize(snake.isAlive ? snake.length : 0);
+      for (uint32_t k = 0; k < geometry.size(); ++k) {
+        geometry[k] = grid.GetCoords(state.GetSegment(snake, k));
+      }
+
+      status = snake.isAlive ? SnakeStatus::Alive : SnakeStatus::Dead;
+    };
+
+    // Snakes past the simulator capacity keep their current bodies
+    uint32_t snakeCount = state.GetSnakeCount();
+    for (uint32_t i = 0; i < std::min<uint64_t>(predicted.snakes.size(), snakeCount); ++i) {
+      PlayerSnake& snake = predicted.snakes[i];
+      readBody(i, snake.geometry, snake.status);
+      snake.oldDirection = snake.direction;
+      snake.direction = DIRECTIONS[state.GetSnake(i).direction];
+    }
+
+    for (uint64_t i = 0; i < predicted.enemies.size() && predicted.snakes.size() + i < snakeCount; ++i) {
+      EnemySnake& enemy = predicted.enemies[i];
+      readBody(static_cast<uint32_t>(predicted.snakes.size() + i), enemy.geometry, enemy.status);
+    }
+
+    auto isEaten = [&state, &grid](const Coords& pos) { return grid.IsInside(pos) && !state.HasFood(grid.GetIndex(pos)); };
+    std::erase_if(predicted.food, [&isEaten](const Food& food) { return isEaten(food.coords); });
+    std::erase_if(predicted.specialFood.golden, isEaten);
+    std::erase_if(predicted.specialFood.suspicious, isEaten);
   }
 
-  void Game::ProcessSnake(const PlayerSnake& snake, const GameState& gameState, const std::unordered_set<Coords, CoordsHash>& globalObstacles, SnakeData& snakeData) {
-    if (snake.status != "alive" || snake.geometry.empty()) { return; }
+  bool Game::IsSpeculationValid(const GameState& gameState) const {
+    const GameState& predicted = m_Speculation.state;
+    if (!m_Speculation.isReady || gameState.turn != predicted.turn || gameState.name != predicted.name
+        || gameState.snakes.size() != predicted.snakes.size() || m_Speculation.snakes.snakesData.size() != gameState.snakes.size()) {
+      return false;
+    }
+
+    // Our own moves are the part of the prediction that has to hold exactly
+    for (uint64_t i = 0; i < gameState.snakes.size(); ++i) {
+      const PlayerSnake& snake = gameState.snakes[i];
+      const PlayerSnake& expected = predicted.snakes[i];
+      if (snake.status != expected.status || snake.geometry.size() != expected.geometry.size()
+          || (!snake.geometry.empty() && snake.geometry.front() != expected.geometry.front())) {
+        return false;
+      }
+    }
+
+    // Enemies did whatever they did, the answer only stands when every move still lands on a free cell no enemy head can enter
+    auto isTaken = [&gameState](const Coords& target) {
+      auto isOnBody = [&target](const std::vector<Coords>& geometry) {
+        return std::find(geometry.begin(), geometry.end(), target) != geometry.end();
+      };
+
+      for (const PlayerSnake& snake : gameState.snakes) {
+        if (snake.status == SnakeStatus::Alive && isOnBody(snake.geometry)) { return true; }
+      }
+
+      for (const EnemySnake& enemy : gameState.enemies) {
+        if (enemy.status != SnakeStatus::Alive || enemy.geometry.empty()) { continue; }
+        if (GetManhattanDistance(enemy.geometry.front(), target) <= 1 || isOnBody(enemy.geometry)) { return true; }
+      }
+
+      return false;
+    };
+
+    for (uint64_t i = 0; i < gameState.snakes.size(); ++i) {
+      const PlayerSnake& snake = gameState.snakes[i];
+      if (snake.status != SnakeStatus::Alive || snake.geometry.empty()) { continue; }
+
+      if (isTaken(snake.geometry.front() + m_Speculation.snakes.snakesData[i].direction)) { return false; }
+    }
+
+    return true;
+  }
+
+  bool Game::ProcessSnake(const PlayerSnake& snake, uint32_t snakeIndex, const TickContext& context, SearchScratch& scratch,
+                          SnakePlan& plan, SnakeData& snakeData) {
+    if (snake.status != SnakeStatus::Alive || snake.geometry.empty()) {
+      plan.isValid = false;
+      return false;
+    }
 
     snakeData.id = snake.id;
+    const Coords& head = snake.geometry.front();
 
-    // Create a local copy of obstacles for this snake
-    std::unordered_set<Coords, CoordsHash> obstacles(globalObstacles);
+    // Plans get better and more expensive, every stage keeps a valid answer in place
+    snakeData.direction = FindSafeMove(head, snake.direction, context);
 
-    // Add other snake bodies
-    for (const PlayerSnake& playerSnake : gameState.snakes) {
-      if (playerSnake.status == "alive") {
-        for (uint64_t j = (playerSnake.id == snake.id ? 1 : 0); j < playerSnake.geometry.size(); ++j) {
-          obstacles.insert(playerSnake.geometry[j]);
-        }
+    // Descend the shared food field, snakes only trigger a local search when they block the way
+    uint8_t fieldMove = context.foodField.FindDescentMove(head, context.obstacles, FIELD_REPAIR_HORIZON);
+    if (fieldMove != FoodDistanceField::NO_MOVE && context.danger.IsContested(context.obstacles.GetIndex(head + DIRECTIONS[fieldMove]), 1)) {
+      fieldMove = FoodDistanceField::NO_MOVE;
+    }
+
+    if (fieldMove != FoodDistanceField::NO_MOVE) {
+      snakeData.direction = DIRECTIONS[fieldMove];
+    }
+
+    scratch.wasCutShort = false;
+
+    // Keep chasing the food of the previous tick unless a better one shows up
+    UpdatePlan(head, snakeIndex, context, scratch, plan);
+    uint32_t bodyLength = static_cast<uint32_t>(snake.geometry.size());
+    uint8_t move = FindPathToBestFood(head, snakeIndex, bodyLength, context, scratch, plan);
+    if (move != SearchScratch::NO_MOVE) {
+      snakeData.direction = DIRECTIONS[move];
+    } else if (fieldMove == FoodDistanceField::NO_MOVE) {
+      // The field descent was blocked close to the head, repair it with a local search
+      move = FindPathToClosestFood(head, context, scratch);
+      if (move != SearchScratch::NO_MOVE) {
+        snakeData.direction = DIRECTIONS[move];
       }
     }
 
-    for (const EnemySnake& enemySnake : gameState.enemies) {
-      if (enemySnake.status == "alive") {
-        for (const Coords& pos : enemySnake.geometry) {
-          obstacles.insert(pos);
+    // Whatever stage answered, never squeeze into a pocket the body does not fit in while there is room elsewhere
+    snakeData.direction = AvoidTraps(head, snakeData.direction, bodyLength, context);
+    return scratch.wasCutShort;
+  }
+
+  void Game::UpdatePlan(const Coords& head, uint32_t snakeIndex, const TickContext& context, SearchScratch& scratch,
+                        SnakePlan& plan) const {
+    if (!plan.isValid) { return; }
+
+    const OccupancyGrid& obstacles = context.obstacles;
+    const FoodIndex::Entry* food = context.foodIndex.Find(plan.goal);
+    if (food == nullptr || GetFoodValue(*food) <= 0.0f || !obstacles.IsInside(head) || !context.territory.CanWin(plan.goal, snakeIndex)) {
+      plan.isValid = false;
+      return;
+    }
+
+    // Drop the steps taken since the last tick, a head off the path means the plan was not followed
+    uint32_t headIndex = obstacles.GetIndex(head);
+    auto it = std::find(plan.cells.begin(), plan.cells.end(), headIndex);
+    if (it == plan.cells.end()) {
+      plan.isValid = false;
+      return;
+    }
+
+    plan.cells.erase(plan.cells.begin(), it + 1);
+
+    // The leg up to a sector portal is done, the next one is planned together with the other candidates
+    if (plan.cells.empty()) {
+      plan.isValid = false;
+      return;
+    }
+
+    // Enemy heads moved since the plan was made, a contested step needs the costs of a full search
+    for (uint64_t step = 0; step < std::min<uint64_t>(plan.cells.size(), DANGER_RADIUS); ++step) {
+      if (context.danger.IsContested(plan.cells[step], static_cast<uint32_t>(step) + 1)) {
+        plan.isValid = false;
+        return;
+      }
+    }
+
+    // The cell at step k is entered k + 1 ticks from now, a snake body on it may have moved on by then
+    const ClearanceMap& clearance = context.clearance;
+    auto isBlocked = [&plan, &obstacles, &clearance](uint64_t step) {
+      uint32_t index = plan.cells[step];
+      return obstacles.Test(index) && !clearance.IsClearAt(index, static_cast<uint32_t>(step) + 1);
+    };
+
+    // Cells freed by moving snakes keep the plan valid, only newly blocked stretches are routed around
+    for (uint32_t repair = 0;; ++repair) {
+      uint64_t blocked = 0;
+      while (blocked < plan.cells.size() && !isBlocked(blocked)) { ++blocked; }
+      if (blocked == plan.cells.size()) { return; }
+
+      uint64_t rejoin = blocked;
+      while (rejoin < plan.cells.size() && isBlocked(rejoin)) { ++rejoin; }
+      if (rejoin == plan.cells.size() || repair == MAX_PLAN_REPAIRS) {
+        plan.isValid = false;
+        return;
+      }
+
+      // The detour starts from the last free cell, which the snake reaches after as many ticks as there are steps before it
+      uint32_t fromIndex = blocked == 0 ? headIndex : plan.cells[blocked - 1];
+      Cell from{ obstacles.GetCoords(fromIndex), fromIndex };
+      uint32_t rejoinIndex = plan.cells[rejoin];
+      if (!FindPath(from, obstacles.GetCoords(rejoinIndex), context, static_cast<uint32_t>(blocked), REPAIR_EXPANSION_LIMIT, scratch)) {
+        plan.isValid = false;
+        return;
+      }
+
+      scratch.ExtractPath(rejoinIndex, obstacles, scratch.pathCells);
+      auto tail = plan.cells.erase(plan.cells.begin() + blocked, plan.cells.begin() + rejoin + 1);
+      plan.cells.insert(tail, scratch.pathCells.begin(), scratch.pathCells.end());
+    }
+  }
+
+  Coords Game::FindSafeMove(const Coords& head, const Coords& currentDirection, const TickContext& context) {
+    const OccupancyGrid& obstacles = context.obstacles;
+    auto isSafe = [&obstacles, &context](const Coords& pos) {
+      return !obstacles.IsBlocked(pos) && !context.danger.IsContested(obstacles.GetIndex(pos), 1);
+    };
+
+    if (isSafe(head + currentDirection)) { return currentDirection; }
+
+    for (const Coords& dir : DIRECTIONS) {
+      if (isSafe(head + dir)) { return dir; }
+    }
+
+    if (!obstacles.IsBlocked(head + currentDirection)) { return currentDirection; }
+
+    for (const Coords& dir : DIRECTIONS) {
+      if (!obstacles.IsBlocked(head + dir)) { return dir; }
+    }
+
+    return currentDirection;
+  }
+
+  Coords Game::AvoidTraps(const Coords& head, const Coords& direction, uint32_t requiredSize, const TickContext& context) {
+    const RegionMap& regions = context.regions;
+    uint32_t regionSize = regions.GetRegionSize(head + direction);
+    if (regionSize >= requiredSize) { return direction; }
+
+    // Enough room comes first, then a cell no enemy head can enter next, then as much room as possible
+    auto getRank = [&context, requiredSize](const Coords& pos, uint32_t size) {
+      bool isContested = context.danger.IsContested(context.obstacles.GetIndex(pos), 1);
+      return std::make_tuple(std::min(size, requiredSize), !isContested, size);
+    };
+
+    Coords best = direction;
+    auto bestRank = regionSize != 0 ? getRank(head + direction, regionSize) : std::make_tuple(0u, false, 0u);
+    for (const Coords& dir : DIRECTIONS) {
+      Coords pos = head + dir;
+      uint32_t size = regions.GetRegionSize(pos);
+      if (size == 0) { continue; }
+
+      auto rank = getRank(pos, size);
+      if (rank > bestRank) {
+        best = dir;
+        bestRank = rank;
+      }
+    }
+
+    return best;
+  }
+
+  uint8_t Game::FindPathToBestFood(const Coords& start, uint32_t snakeIndex, uint32_t minRegionSize, const TickContext& context,
+                                   SearchScratch& scratch, SnakePlan& plan) {
+    const OccupancyGrid& obstacles = context.obstacles;
+    if (context.foodIndex.IsEmpty() || !obstacles.IsInside(start)) { return SearchScratch::NO_MOVE; }
+
+    // A kept plan sets the bar, only food that could beat its rate is searched
+    float bestRate = 0.0f;
+    if (plan.isValid) {
+      bestRate = GetFoodValue(*context.foodIndex.Find(plan.goal)) / static_cast<float>(plan.GetLength());
+    }
+
+    // Rank food by its value over the Manhattan distance, an upper bound of the real points per tick
+    const std::vector<FoodIndex::Entry>& foods = context.foodIndex.GetEntries();
+    scratch.targets.clear();
+    for (uint32_t i = 0; i < foods.size(); ++i) {
+      const FoodIndex::Entry& food = foods[i];
+      float value = GetFoodValue(food);
+      if (value <= 0.0f || food.coords == start || obstacles.IsBlocked(food.coords)) { continue; }
+      if (plan.isValid && food.coords == plan.goal) { continue; }
+      if (context.regions.GetRegionSize(food.coords) < minRegionSize || !context.territory.CanWin(food.coords, snakeIndex)) { continue; }
+
+      float estimate = value / static_cast<float>(GetManhattanDistance(start, food.coords));
+      if (estimate > bestRate) {
+        scratch.targets.emplace_back(estimate, i);
+      }
+    }
+
+    uint64_t candidateCount = std::min<uint64_t>(PLANNER_CANDIDATE_COUNT, scratch.targets.size());
+    std::partial_sort(scratch.targets.begin(), scratch.targets.begin() + candidateCount, scratch.targets.end(),
+                      [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    Cell startCell{ start, obstacles.GetIndex(start) };
+    auto adoptPath = [&plan, &foods](uint32_t entryIndex, const PlannedPath& path, std::vector<uint32_t>& cells) {
+      plan.cells.swap(cells);
+      plan.goal = foods[entryIndex].coords;
+      plan.remainingLength = path.length - static_cast<uint32_t>(plan.cells.size());
+      plan.isValid = true;
+    };
+
+    if (m_SplitSearches && candidateCount > 1) {
+      // The helping thread may run other tasks on this slot while it waits, nothing in the scratch survives the call
+      std::array<uint32_t, PLANNER_CANDIDATE_COUNT> candidates{};
+      for (uint64_t i = 0; i < candidateCount; ++i) {
+        candidates[i] = scratch.targets[i].second;
+      }
+
+      // Plan sized the groups for the deepest nesting, the buffers never move while stolen tasks write them
+      WorkerArena& arena = m_Arenas[m_ThreadPool->GetCurrentSlot()];
+      std::vector<uint32_t>* cells = arena.candidateCells.data() + static_cast<uint64_t>(arena.splitDepth++) * PLANNER_CANDIDATE_COUNT;
+
+      bool wasCutShort = scratch.wasCutShort;
+      std::atomic<bool> anyCutShort = false;
+      std::array<std::optional<PlannedPath>, PLANNER_CANDIDATE_COUNT> paths;
+      m_ThreadPool->ParallelFor(static_cast<uint32_t>(candidateCount), [&](uint32_t index, uint32_t slot) {
+        SearchScratch& taskScratch = m_Arenas[slot].scratch;
+        bool taskWasCutShort = taskScratch.wasCutShort;
+        taskScratch.wasCutShort = false;
+
+        paths[index] = PlanPath(startCell, foods[candidates[index]].coords, context, taskScratch);
+        if (paths[index]) {
+          taskScratch.ExtractPath(paths[index]->target, obstacles, cells[index]);
         }
-        AddSurroundingCellsAsObstacles(enemySnake.geometry[0], obstacles, gameState.mapSize);
-      }
-    }
-
-    snakeData.direction = FindPathToClosestFood(
-      snake.geometry.front(),
-      snake.direction,
-      obstacles,
-      gameState.food,
-      gameState.specialFood,
-      gameState.mapSize
-    );
-  }
-
-  Coords Game::FindPathToClosestFood(const Coords& start, const Coords& currentDirection, const std::unordered_set<Coords, CoordsHash>& obstacles,
-                                     const std::vector<Food>& foods, const SpecialFood& specialFoods, const Coords& mapSize) {
-    if (foods.empty()) { return currentDirection; }
-
-    std::queue<Cell> queue;
-    std::unordered_set<Coords, CoordsHash> visited;
-    queue.push({ start, {} });
-    visited.insert(start);
-
-    while (!queue.empty()) {
-      Cell current = queue.front();
-      queue.pop();
-
-      // Check if current position contains fruit
-      for (const Food& food : foods) {
-        if (food.coords == current.pos) {
-          if (current.path.empty()) {
-            for (const Coords& dir : DIRECTIONS) {
-              Coords newPos(current.pos);
-              newPos += dir;
-              if (IsWithinMapBounds(newPos, mapSize)) { return dir; }
-            }
-          }
-          return current.path.front();
+
+        if (taskScratch.wasCutShort) {
+          anyCutShort.store(true, std::memory_order_relaxed);
+        }
+
+        taskScratch.wasCutShort = taskWasCutShort;
+      });
+      scratch.wasCutShort = wasCutShort || anyCutShort.load(std::memory_order_relaxed);
+      --arena.splitDepth;
+
+      for (uint64_t i = 0; i < candidateCount; ++i) {
+        if (!paths[i]) { continue; }
+
+        float rate = GetFoodValue(foods[candidates[i]]) / static_cast<float>(paths[i]->length);
+        if (rate > bestRate) {
+          bestRate = rate;
+          adoptPath(candidates[i], *paths[i], cells[i]);
         }
       }
+    } else {
+      for (uint64_t i = 0; i < candidateCount; ++i) {
+        auto [estimate, entryIndex] = scratch.targets[i];
+
+        // Remaining candidates cannot beat a rate that was already verified
+        if (estimate <= bestRate) { break; }
+
+        if (context.deadline.IsExpired()) {
+          scratch.wasCutShort = true;
+          break;
+        }
+
+        const FoodIndex::Entry& food = foods[entryIndex];
+        std::optional<PlannedPath> path = PlanPath(startCell, food.coords, context, scratch);
+        if (!path) { continue; }
+
+        float rate = GetFoodValue(food) / static_cast<float>(path->length);
+        if (rate > bestRate) {
+          bestRate = rate;
+          scratch.ExtractPath(path->target, obstacles, scratch.pathCells);
+          adoptPath(entryIndex, *path, scratch.pathCells);
+        }
+      }
+    }
+
+    if (!plan.isValid || plan.cells.empty()) { return SearchScratch::NO_MOVE; }
+
+    return GetMoveTowards(start, obstacles.GetCoords(plan.cells.front()));
+  }
+
+  std::optional<Game::PlannedPath> Game::PlanPath(const Cell& start, const Coords& goal, const TickContext& context,
+                                                  SearchScratch& scratch) const {
+    const OccupancyGrid& obstacles = context.obstacles;
+    if (IsWithinSectorBounds(start.pos, goal)) {
+      std::optional<std::pair<uint8_t, uint32_t>> path = FindPath(start, goal, context, 0, PLANNER_EXPANSION_LIMIT, scratch);
+      if (!path) { return std::nullopt; }
+
+      return PlannedPath{ .move = path->first, .length = path->second, .target = obstacles.GetIndex(goal) };
+    }
+
+    std::optional<SectorGraph::Route> route = m_Sectors.FindRoute(start.pos, goal, scratch);
+    if (!route) { return std::nullopt; }
+
+    std::optional<std::pair<uint8_t, uint32_t>> path = FindPath(start, obstacles.GetCoords(route->waypoint), context, 0,
+                                                                PLANNER_EXPANSION_LIMIT, scratch);
+    if (!path || path->first == SearchScratch::NO_MOVE) { return std::nullopt; }
+
+    // The detailed path replaces the abstract estimate of the first leg
+    return PlannedPath{ .move = path->first, .length = path->second + route->length - route->waypointDistance, .target = route->waypoint };
+  }
+
+  std::optional<std::pair<uint8_t, uint32_t>> Game::FindPath(const Cell& start, const Coords& goal, const TickContext& context,
+                                                             uint32_t startTick, uint32_t expansionLimit, SearchScratch& scratch) {
+    const OccupancyGrid& obstacles = context.obstacles;
+    const ClearanceMap& clearance = context.clearance;
+    scratch.Prepare(obstacles.GetCellCount());
+
+    // std heap functions build a max-heap, invert the order to pop the lowest score first
+    auto compare = [](const WeightedCell& lhs, const WeightedCell& rhs) { return rhs < lhs; };
+
+    scratch.Visit(start.index, SearchScratch::NO_MOVE, 0, SearchScratch::NO_MOVE, 0);
+    scratch.heap.push_back({ start, GetPathScore(0, start.pos, goal) });
+
+    uint32_t expanded = 0;
+    while (!scratch.heap.empty()) {
+      std::pop_heap(scratch.heap.begin(), scratch.heap.end(), compare);
+      WeightedCell current = scratch.heap.back();
+      scratch.heap.pop_back();
+
+      const Coords& pos = current.cell.pos;
+      uint32_t cost = scratch.costs[current.cell.index];
+
+      // Skip entries that were superseded by a cheaper path
+      if (current.score > GetPathScore(cost, pos, goal)) { continue; }
+
+      uint8_t firstMove = scratch.firstMoves[current.cell.index];
+      if (pos == goal) { return std::make_pair(firstMove, cost); }
+
+      if (++expanded > expansionLimit) { return std::nullopt; }
+
+      if (expanded % DEADLINE_CHECK_INTERVAL == 0 && context.deadline.IsExpired()) {
+        scratch.wasCutShort = true;
+        return std::nullopt;
+      }
+
+      // Every step takes one tick, so the step count is the arrival time at the cell
+      uint32_t newSteps = scratch.steps[current.cell.index] + 1;
+      uint32_t arrivalTick = startTick + newSteps;
+
+      for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+        Coords newPos = pos + DIRECTIONS[i];
+        if (!obstacles.IsInside(newPos)) { continue; }
+
+        uint32_t newIndex = obstacles.GetIndex(newPos);
+        if (obstacles.Test(newIndex) && !clearance.IsClearAt(newIndex, arrivalTick)) { continue; }
+
+        uint32_t newCost = cost + 1 + GetDangerPenalty(context.danger, newIndex, arrivalTick);
+        if (scratch.IsVisited(newIndex) && scratch.costs[newIndex] <= newCost) { continue; }
+
+        scratch.Visit(newIndex, firstMove == SearchScratch::NO_MOVE ? i : firstMove, newCost, i, newSteps);
+        scratch.heap.push_back({ Cell{ newPos, newIndex }, GetPathScore(newCost, newPos, goal) });
+        std::push_heap(scratch.heap.begin(), scratch.heap.end(), compare);
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  uint8_t Game::FindPathToClosestFood(const Coords& start, const TickContext& context, SearchScratch& scratch) {
+    const OccupancyGrid& obstacles = context.obstacles;
+    const FoodIndex& foodIndex = context.foodIndex;
+    if (foodIndex.IsEmpty() || !obstacles.IsInside(start)) { return SearchScratch::NO_MOVE; }
+
+    // Jumping pays off when most of the bricks around the start are empty
+    const BrickGrid& bricks = context.bricks;
+    int32_t brickSize = static_cast<int32_t>(bricks.GetBrickSize());
+    uint32_t emptyBricks = 0;
+    uint32_t nearbyBricks = 0;
+    for (int32_t dz = -1; dz <= 1; ++dz) {
+      for (int32_t dy = -1; dy <= 1; ++dy) {
+        for (int32_t dx = -1; dx <= 1; ++dx) {
+          Coords pos = start + Coords{ dx * brickSize, dy * brickSize, dz * brickSize };
+          if (!bricks.IsInside(pos)) { continue; }
+
+          ++nearbyBricks;
+          emptyBricks += bricks.IsBrickEmpty(bricks.GetBrickIndex(pos));
+        }
+      }
+    }
+
+    if (emptyBricks * 2 >= nearbyBricks) {
+      return FindJumpPathToClosestFood(start, context, scratch);
+    }
+
+    scratch.Prepare(obstacles.GetCellCount());
+
+    uint32_t startIndex = obstacles.GetIndex(start);
+    scratch.Visit(startIndex, SearchScratch::NO_MOVE);
+    scratch.frontier.Push(startIndex);
+
+    uint32_t expanded = 0;
+    while (!scratch.frontier.IsEmpty()) {
+      if (++expanded % DEADLINE_CHECK_INTERVAL == 0 && context.deadline.IsExpired()) {
+        scratch.wasCutShort = true;
+        return SearchScratch::NO_MOVE;
+      }
+
+      uint32_t index = scratch.frontier.Pop();
+      Coords pos = obstacles.GetCoords(index);
+      uint8_t firstMove = scratch.firstMoves[index];
+
+      // Check if current position contains fruit, food under the head is already being eaten
+      if (firstMove != SearchScratch::NO_MOVE && foodIndex.Contains(pos)) { return firstMove; }
 
       // Try all possible directions
-      for (const Coords& dir : DIRECTIONS) {
-        Coords newPos(current.pos);
-        newPos += dir;
+      for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+        Coords newPos = pos + DIRECTIONS[i];
 
-        // Check boundaries
-        if (IsWithinSectorBounds(newPos, current.pos) && !IsWithinMapBounds(newPos, mapSize)) { continue; }
+        // Check boundaries and obstacles
+        if (obstacles.IsBlocked(newPos)) { continue; }
 
-        // Check if position is visited or contains obstacle
-        if (visited.contains(newPos) || obstacles.contains(newPos)) { continue; }
+        // Check if position is visited
+        uint32_t newIndex = obstacles.GetIndex(newPos);
+        if (scratch.IsVisited(newIndex)) { continue; }
 
-        // Create new path by adding current direction
-        std::vector<Coords> newPath(current.path);
-        newPath.push_back(dir);
+        // A first step next to an enemy head risks a head-on collision
+        if (firstMove == SearchScratch::NO_MOVE && context.danger.IsContested(newIndex, 1)) { continue; }
 
-        // Add new cell to queue
-        queue.emplace(newPos, std::move(newPath));
-        visited.insert(std::move(newPos));
+        // Neighbors inherit the first move of the path that reached them
+        scratch.Visit(newIndex, firstMove == SearchScratch::NO_MOVE ? i : firstMove);
+        scratch.frontier.Push(newIndex);
       }
     }
 
-    return {};
+    return SearchScratch::NO_MOVE;
   }
 
-  void Game::AddSurroundingCellsAsObstacles(const Coords& position, std::unordered_set<Coords, CoordsHash>& obstacles, const Coords& mapSize) {
-    for (const Coords& dir : DIRECTIONS) {
-      Coords pos = position + dir;
-      if (pos.x < 0 || pos.x > mapSize.x
-          || pos.y < 0 || pos.y > mapSize.y
-          || pos.z < 0 || pos.z > mapSize.z) {
-        continue;
+  uint8_t Game::FindJumpPathToClosestFood(const Coords& start, const TickContext& context, SearchScratch& scratch) {
+    const OccupancyGrid& obstacles = context.obstacles;
+    const DangerField& danger = context.danger;
+    scratch.Prepare(obstacles.GetCellCount());
+
+    // Jumps have different lengths, jump points are expanded in order of their distance
+    auto compare = [](const WeightedCell& lhs, const WeightedCell& rhs) { return rhs < lhs; };
+
+    uint32_t startIndex = obstacles.GetIndex(start);
+    scratch.Visit(startIndex, SearchScratch::NO_MOVE, 0, SearchScratch::NO_MOVE, 0);
+    scratch.heap.push_back({ Cell{ start, startIndex }, 0.0f });
+
+    // Jumps count the cells they walk and look at the clock themselves, a single one can sweep whole planes
+    uint32_t scanned = 0;
+    while (!scratch.heap.empty()) {
+      std::pop_heap(scratch.heap.begin(), scratch.heap.end(), compare);
+      WeightedCell current = scratch.heap.back();
+      scratch.heap.pop_back();
+
+      const Coords& pos = current.cell.pos;
+      uint32_t cost = scratch.costs[current.cell.index];
+      if (current.score > static_cast<float>(cost)) { continue; }
+
+      uint8_t firstMove = scratch.firstMoves[current.cell.index];
+      if (firstMove != SearchScratch::NO_MOVE && context.foodIndex.Contains(pos)) { return firstMove; }
+
+      // The start may go anywhere. Other jump points keep their axis, turn onto later axes and take their forced neighbors.
+      uint8_t arrival = scratch.arrivalMoves[current.cell.index];
+      for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+        if (arrival != SearchScratch::NO_MOVE && i != arrival && GetAxis(i) <= GetAxis(arrival)
+            && (GetAxis(i) == GetAxis(arrival) || !IsForcedNeighbor(pos, arrival, i, start, danger, obstacles))) {
+          continue;
+        }
+
+        uint32_t steps = Jump(pos, i, start, context, scanned);
+        if (steps == JUMP_CUT_SHORT) {
+          scratch.wasCutShort = true;
+          return SearchScratch::NO_MOVE;
+        }
+
+        if (steps == 0) { continue; }
+
+        Coords newPos = pos + Coords{ DIRECTIONS[i].x * static_cast<int32_t>(steps), DIRECTIONS[i].y * static_cast<int32_t>(steps),
+                                      DIRECTIONS[i].z * static_cast<int32_t>(steps) };
+        uint32_t newIndex = obstacles.GetIndex(newPos);
+        uint32_t newCost = cost + steps;
+        if (scratch.IsVisited(newIndex) && scratch.costs[newIndex] <= newCost) { continue; }
+
+        scratch.Visit(newIndex, firstMove == SearchScratch::NO_MOVE ? i : firstMove, newCost, i, newCost);
+        scratch.heap.push_back({ Cell{ newPos, newIndex }, static_cast<float>(newCost) });
+        std::push_heap(scratch.heap.begin(), scratch.heap.end(), compare);
+      }
+    }
+
+    return SearchScratch::NO_MOVE;
+  }
+
+  uint32_t Game::Jump(const Coords& pos, uint8_t direction, const Coords& start, const TickContext& context, uint32_t& scanned) {
+    const OccupancyGrid& obstacles = context.obstacles;
+    const BrickGrid& bricks = context.bricks;
+    const DangerField& danger = context.danger;
+    uint8_t axis = GetAxis(direction);
+    int32_t brickMask = static_cast<int32_t>(bricks.GetBrickSize()) - 1;
+
+    // Cells ahead that are known to be free and to have no forced neighbor
+    uint32_t openSteps = 0;
+
+    Coords current = pos;
+    for (uint32_t steps = 1;; ++steps) {
+      current += DIRECTIONS[direction];
+      if (++scanned % DEADLINE_CHECK_INTERVAL == 0 && context.deadline.IsExpired()) { return JUMP_CUT_SHORT; }
+
+      if (openSteps > 0) {
+        --openSteps;
+      } else {
+        if (IsJumpBlocked(current, start, danger, obstacles)) { return 0; }
+
+        for (uint8_t i = 0; i < axis * 2; ++i) {
+          if (IsForcedNeighbor(current, direction, i, start, danger, obstacles)) { return steps; }
+        }
+
+        // In an empty brick with empty bricks beside it on the earlier axes, nothing up to the far face of the brick
+        // is blocked or forced. Cells near the start are left to the full check, an enemy head may block them.
+        if (bricks.IsBrickEmpty(current) && GetManhattanDistance(current, start) > static_cast<uint32_t>(brickMask) + 3) {
+          bool isOpen = true;
+          for (uint8_t i = 0; i < axis * 2 && isOpen; ++i) {
+            isOpen = bricks.IsBrickEmpty(current + DIRECTIONS[i]);
+          }
+
+          if (isOpen) {
+            // Even directions point along their axis, odd ones against it. Bricks on the far faces of the map are cut by it.
+            int32_t coordinate = GetCoordinate(current, axis);
+            int32_t offset = coordinate & brickMask;
+            openSteps = static_cast<uint32_t>((direction & 1) == 0
+              ? std::min(brickMask - offset, GetCoordinate(obstacles.GetExtent(), axis) - 1 - coordinate) : offset);
+          }
+        }
+      }
+
+      if (context.foodIndex.Contains(current)) { return steps; }
+
+      // A cell where a turn onto a later axis leads to a jump point is a jump point itself
+      for (uint8_t i = (axis + 1) * 2; i < DIRECTIONS.size(); ++i) {
+        uint32_t turnSteps = Jump(current, i, start, context, scanned);
+        if (turnSteps == JUMP_CUT_SHORT) { return JUMP_CUT_SHORT; }
+        if (turnSteps != 0) { return steps; }
       }
-      obstacles.insert(std::move(pos));
     }
   }
-}
\ No newline at end of file
+}
@@ -2,38 +2,151 @@
 
 #include "pch.h"
 
-#include <raylib.h>
+#include "OccupancyGrid.h"
+#include "WorldModel.h"
+#include "FoodIndex.h"
+#include "FoodDistanceField.h"
+#include "DangerField.h"
+#include "RegionMap.h"
+#include "TerritoryMap.h"
+#include "SearchScratch.h"
+#include "SectorGraph.h"
+#include "Simulator.h"
+#include "RolloutEvaluator.h"
+
+#include "Utils/Deadline.h"
+#include "Utils/ThreadPool.h"
 
-struct CoordsHash {
-  inline size_t operator()(const Snake::Coords& v) const {
-    return std::hash<int32_t>()(v.x) ^ (std::hash<int32_t>()(v.y) << 1) ^ (std::hash<int32_t>()(v.z) << 2);
-  }
-};
+#include <raylib.h>
 
 namespace Snake {
   class Game {
   public:
-    Game() = default;
+    Game();
     ~Game() = default;
 
+    // Sends the speculative answer when the tick went as predicted, otherwise plans the tick and sends the result
     void Update(const GameState& gameState);
 
+    // Plans the tick expected to follow gameState while waiting for it. Runs after the moves of gameState were sent.
+    void Speculate(const GameState& gameState, const Utils::Deadline& deadline);
+
+    // Recreates the planner pool, a worker count of zero uses every hardware thread
+    void ConfigureWorkers(uint32_t workerCount, bool pinWorkers = false);
+
   private:
     struct SnakeData {
       std::string id;
       Coords direction{ 0, 0, 0 };
     };
 
-    static void ProcessSnake(const PlayerSnake& snake, const GameState& gameState, const std::unordered_set<Coords, CoordsHash>& globalObstacles, SnakeData& snakeData);
+    // Everything the planner reads during a tick, shared between workers
+    struct TickContext {
+      const OccupancyGrid& obstacles;
+      const BrickGrid& bricks;
+      const ClearanceMap& clearance;
+      const DangerField& danger;
+      const RegionMap& regions;
+      const TerritoryMap& territory;
+      const FoodIndex& foodIndex;
+      const FoodDistanceField& foodField;
+      Utils::Deadline deadline;
+    };
 
-    static Coords FindPathToClosestFood(const Coords& start, const Coords& currentDirection, const std::unordered_set<Coords, CoordsHash>& obstacles,
-                                        const std::vector<Food>& foods, const SpecialFood& specialFoods, const Coords& mapSize);
+    // Search buffers owned by one pool slot. The candidate paths of a split search are written into the arena of
+    // the slot that split it, one buffer per candidate, and the adopted one is swapped with the old plan cells.
+    // A slot waiting for its split may start the split of another snake, nested splits take the next group of buffers.
+    struct alignas(Utils::CACHE_LINE_SIZE) WorkerArena {
+      SearchScratch scratch;
+      std::vector<std::vector<uint32_t>> candidateCells;
+      uint32_t splitDepth = 0;
+    };
 
-    static void AddSurroundingCellsAsObstacles(const Coords& position, std::unordered_set<Coords, CoordsHash>& obstacles, const Coords& mapSize);
+    // Path towards one food kept between ticks. The cells end at the food, or at the portal where a sector route
+    // leaves the current sector, in which case the rest of the route is only known as an estimated length.
+    struct SnakePlan {
+      std::vector<uint32_t> cells;
+      Coords goal{ 0, 0, 0 };
+      uint32_t remainingLength = 0;
+      uint32_t lastTurn = 0;
+      bool isValid = false;
 
-    static inline bool IsWithinMapBounds(const Coords& pos, const Coords& mapSize) {
-      return pos.x >= 0 && pos.x <= mapSize.x && pos.y >= 0 && pos.y <= mapSize.y && pos.z >= 0 && pos.z <= mapSize.z;
-    }
+      inline uint32_t GetLength() const noexcept { return static_cast<uint32_t>(cells.size()) + remainingLength; }
+    };
+
+    // Written by exactly one worker per tick, padded so neighbouring snakes never share a cache line
+    struct alignas(Utils::CACHE_LINE_SIZE) SnakeSlot {
+      SnakeData data;
+      SnakePlan* plan = nullptr;
+      bool wasCutShort = false;
+    };
+
+    struct PlannedPath {
+      uint8_t move = SearchScratch::NO_MOVE;
+
+      // Estimated cost to the goal, steps plus danger penalties
+      uint32_t length = 0;
+
+      // Cell the detailed search ended on, the goal or a sector portal
+      uint32_t target = 0;
+    };
+
+    // Runs the whole planner on gameState and writes the moves to m_Json, returns false when they could not be written.
+    // Without speculation the moves are sent right after, and rollouts only get a share of the time left.
+    bool Plan(const GameState& gameState, const Utils::Deadline& deadline, bool isSpeculative);
+
+    // Applies the moves in m_Snakes to gameState, enemies keep going straight while they can
+    void PredictNextState(const GameState& gameState, GameState& predicted);
+
+    // Cheap check that the speculative answer still fits: our snakes are where the prediction put them,
+    // and every move lands on a cell no body covers and no enemy head can enter
+    bool IsSpeculationValid(const GameState& gameState) const;
+
+    // Returns true when the deadline cut one of the searches short
+    bool ProcessSnake(const PlayerSnake& snake, uint32_t snakeIndex, const TickContext& context, SearchScratch& scratch, SnakePlan& plan,
+                      SnakeData& snakeData);
+
+    // Advances the plan of the previous tick to the current head and splices local detours around cells that became blocked.
+    // Invalidates the plan when its food is gone or lost to another snake, or a repair would cost about as much as planning again.
+    void UpdatePlan(const Coords& head, uint32_t snakeIndex, const TickContext& context, SearchScratch& scratch, SnakePlan& plan) const;
+
+    // Keeps the current direction when it is free, otherwise takes any free neighbor.
+    // Neighbors an enemy head can enter on the next tick are only taken when nothing else is free.
+    static Coords FindSafeMove(const Coords& head, const Coords& currentDirection, const TickContext& context);
+
+    // Swaps a move into a region smaller than the required size for the neighbor with the most room.
+    // Among neighbors with enough room, the ones no enemy head can enter on the next tick are preferred.
+    static Coords AvoidTraps(const Coords& head, const Coords& direction, uint32_t requiredSize, const TickContext& context);
+
+    // Ranks food by value over distance and runs A* towards the candidates that could beat the current plan.
+    // Food in regions smaller than minRegionSize is skipped, the snake would not fit behind it, and so is food in the
+    // territory of another snake. Replaces the plan when a better food is found, returns SearchScratch::NO_MOVE when
+    // there is no plan to follow. Candidates are searched in parallel when the pool has more slots than there are snakes.
+    uint8_t FindPathToBestFood(const Coords& start, uint32_t snakeIndex, uint32_t minRegionSize, const TickContext& context,
+                               SearchScratch& scratch, SnakePlan& plan);
+
+    // Searches nearby goals directly. Far goals are planned across sector portals, and the detailed search only
+    // runs up to the portal where the route leaves the current sector.
+    std::optional<PlannedPath> PlanPath(const Cell& start, const Coords& goal, const TickContext& context, SearchScratch& scratch) const;
+
+    // A* with a Manhattan heuristic, returns the first move and path cost towards the goal.
+    // The start is reached at startTick, snake cells are entered when they clear before the path arrives
+    // and cells an enemy head can reach first cost extra.
+    // The path itself can be read back with SearchScratch::ExtractPath until the next search.
+    static std::optional<std::pair<uint8_t, uint32_t>> FindPath(const Cell& start, const Coords& goal, const TickContext& context,
+                                                                uint32_t startTick, uint32_t expansionLimit, SearchScratch& scratch);
+
+    // Breadth-first search towards the nearest food. Open surroundings go through a jump point search instead,
+    // cluttered ones gain nothing from jumping and keep the plain expansion.
+    static uint8_t FindPathToClosestFood(const Coords& start, const TickContext& context, SearchScratch& scratch);
+
+    // Jump point search over the 6-connected grid. Paths move along x first, then y, then z, and only turn back to an
+    // earlier axis around an obstacle, so of all equally short paths only one is expanded.
+    static uint8_t FindJumpPathToClosestFood(const Coords& start, const TickContext& context, SearchScratch& scratch);
+
+    // Steps from pos along the direction up to the next jump point, zero when the walk runs into an obstacle first
+    // and JUMP_CUT_SHORT when the deadline passed. Cells next to the start that an enemy head can enter count as obstacles.
+    static uint32_t Jump(const Coords& pos, uint8_t direction, const Coords& start, const TickContext& context, uint32_t& scanned);
 
     static inline Coords GetSectorCoords(const Coords& pos) {
       return Coords{ static_cast<int32_t>(pos.x / SECTOR_SIZE), static_cast<int32_t>(pos.y / SECTOR_SIZE), static_cast<int32_t>(pos.z / SECTOR_SIZE) };
@@ -46,20 +159,6 @@ namespace Snake {
     }
 
   private:
-    struct Cell {
-      Coords pos{ 0, 0, 0 };
-      std::vector<Coords> path;
-    };
-
-    struct WeightedCell {
-      Cell cell;
-      float score = 0.0f;
-
-      inline bool operator<(const WeightedCell& other) const {
-        return score < other.score;
-      }
-    };
-
     struct Snakes {
       std::vector<SnakeData> snakesData;
     };
@@ -67,6 +166,43 @@ namespace Snake {
     Snakes m_Snakes;
     std::string m_Json;
 
+    // Answer for the predicted next tick, planned during the idle part of the current one
+    struct Speculation {
+      GameState state;
+      Snakes snakes;
+      std::string json;
+      bool isReady = false;
+    };
+
+    Speculation m_Speculation;
+    SimState m_PredictionState;
+    uint64_t m_ReceivedTicks = 0;
+    uint64_t m_SpeculationHits = 0;
+
+    WorldModel m_World;
+    FoodIndex m_FoodIndex;
+    FoodDistanceField m_FoodField;
+    DangerField m_Danger;
+    RegionMap m_Regions;
+    TerritoryMap m_Territory;
+    SectorGraph m_Sectors;
+
+    // Forward model of the tick, rollouts check the planned moves against randomized enemy play
+    Simulator m_Simulator;
+    RolloutEvaluator m_Rollouts;
+    std::vector<uint8_t> m_PlannedMoves;
+
+    // Plans of our snakes by interned id, the vector is grown before the workers start so it never reallocates concurrently
+    std::vector<SnakePlan> m_Plans;
+
+    std::unique_ptr<Utils::ThreadPool> m_ThreadPool;
+    std::vector<WorkerArena> m_Arenas;
+    std::vector<SnakeSlot> m_SnakeSlots;
+    bool m_SplitSearches = false;
+
+    uint64_t m_PlannedTicks = 0;
+    uint64_t m_CutShortTicks = 0;
+
     friend struct glz::meta<SnakeData>;
     friend struct glz::meta<Snakes>;
   };
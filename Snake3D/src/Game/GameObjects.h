@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <cstdlib>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <glaze/glaze.hpp>
@@ -48,9 +51,26 @@ namespace Snake {
     };
   }
 
+  inline uint32_t GetManhattanDistance(const Coords& lhs, const Coords& rhs) noexcept {
+    return static_cast<uint32_t>(std::abs(lhs.x - rhs.x) + std::abs(lhs.y - rhs.y) + std::abs(lhs.z - rhs.z));
+  }
+
+  constexpr std::array<Coords, 6> DIRECTIONS = {
+    Coords{ 1, 0, 0 }, Coords{ -1, 0, 0 },
+    Coords{ 0, 1, 0 }, Coords{ 0, -1, 0 },
+    Coords{ 0, 0, 1 }, Coords{ 0, 0, -1 }
+  };
+
+  // DIRECTIONS are stored in opposite pairs
+  constexpr inline uint8_t GetOppositeDirection(uint8_t direction) noexcept { return direction ^ 1; }
+
+  enum class SnakeStatus : uint8_t {
+    Dead, Alive
+  };
+
   struct EnemySnake {
     std::vector<Coords> geometry;
-    std::string status = "dead";
+    SnakeStatus status = SnakeStatus::Dead;
     uint32_t kills = 0;
   };
 
@@ -60,8 +80,31 @@ namespace Snake {
     Coords direction{ 0, 0, 0 };
     Coords oldDirection{ 0, 0, 0 };
     uint32_t deathCount = 0;
-    std::string status = "dead";
+    SnakeStatus status = SnakeStatus::Dead;
     uint32_t reviveRemainMs = 0;
+
+    // Small number standing for the id, assigned by SnakeIdTable after parsing and not part of the json
+    uint32_t key = 0;
+  };
+
+  // Gives every snake id a small number that stays the same for as long as the table lives.
+  // Only a handful of ids ever show up, so a linear search beats hashing them.
+  class SnakeIdTable {
+  public:
+    uint32_t Intern(std::string_view id) {
+      for (uint64_t i = m_Ids.size(); i-- > 0;) {
+        if (m_Ids[i] == id) { return static_cast<uint32_t>(i); }
+      }
+
+      m_Ids.emplace_back(id);
+      return static_cast<uint32_t>(m_Ids.size() - 1);
+    }
+
+    inline const std::string& GetId(uint32_t key) const noexcept { return m_Ids[key]; }
+    inline uint32_t GetCount() const noexcept { return static_cast<uint32_t>(m_Ids.size()); }
+
+  private:
+    std::vector<std::string> m_Ids;
   };
 
   struct Food {
@@ -101,6 +144,15 @@ struct glz::meta<Snake::Coords> {
   );
 };
 
+template <>
+struct glz::meta<Snake::SnakeStatus> {
+  using enum Snake::SnakeStatus;
+  static constexpr auto value = enumerate(
+    "dead", Dead,
+    "alive", Alive
+  );
+};
+
 template <>
 struct glz::meta<Snake::EnemySnake> {
   using T = Snake::EnemySnake;
@@ -0,0 +1,21 @@
+#include "OccupancyGrid.h"
+
+namespace Snake {
+  void OccupancyGrid::Resize(const Coords& mapSize) {
+    m_Extent = Coords{ std::max(mapSize.x, 0), std::max(mapSize.y, 0), std::max(mapSize.z, 0) };
+    m_StrideY = static_cast<uint32_t>(m_Extent.x);
+    m_StrideZ = static_cast<uint32_t>(m_Extent.x) * static_cast<uint32_t>(m_Extent.y);
+    m_CellCount = m_StrideZ * static_cast<uint32_t>(m_Extent.z);
+
+    for (uint64_t i = 0; i < DIRECTIONS.size(); ++i) {
+      const Coords& dir = DIRECTIONS[i];
+      m_DirectionOffsets[i] = dir.x + dir.y * static_cast<int32_t>(m_StrideY) + dir.z * static_cast<int32_t>(m_StrideZ);
+    }
+
+    m_Words.assign((m_CellCount + 63) / 64, 0);
+  }
+
+  void OccupancyGrid::Clear() noexcept {
+    std::fill(m_Words.begin(), m_Words.end(), 0);
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "pch.h"
+
+namespace Snake {
+  // Bit-packed occupancy volume covering [0, mapSize) on every axis.
+  // Cells are laid out x-fastest, so a linear index is x + y * strideY + z * strideZ.
+  class OccupancyGrid {
+  public:
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    OccupancyGrid() = default;
+    explicit OccupancyGrid(const Coords& mapSize) { Resize(mapSize); }
+
+    // Resizes the grid to the given map size and clears every cell
+    void Resize(const Coords& mapSize);
+    void Clear() noexcept;
+
+    inline void Set(uint32_t index) noexcept { m_Words[index >> 6] |= uint64_t(1) << (index & 63); }
+    inline void Reset(uint32_t index) noexcept { m_Words[index >> 6] &= ~(uint64_t(1) << (index & 63)); }
+    inline bool Test(uint32_t index) const noexcept { return (m_Words[index >> 6] >> (index & 63)) & 1; }
+
+    inline void Set(const Coords& pos) noexcept {
+      if (IsInside(pos)) { Set(GetIndex(pos)); }
+    }
+
+    // Cells outside of the map are always reported as blocked
+    inline bool IsBlocked(const Coords& pos) const noexcept {
+      return !IsInside(pos) || Test(GetIndex(pos));
+    }
+
+    inline bool IsInside(const Coords& pos) const noexcept {
+      return static_cast<uint32_t>(pos.x) < static_cast<uint32_t>(m_Extent.x)
+        && static_cast<uint32_t>(pos.y) < static_cast<uint32_t>(m_Extent.y)
+        && static_cast<uint32_t>(pos.z) < static_cast<uint32_t>(m_Extent.z);
+    }
+
+    inline uint32_t GetIndex(const Coords& pos) const noexcept {
+      return static_cast<uint32_t>(pos.x) + static_cast<uint32_t>(pos.y) * m_StrideY + static_cast<uint32_t>(pos.z) * m_StrideZ;
+    }
+
+    // Index of the neighbor in DIRECTIONS[direction], the caller has to make sure it is inside the map
+    inline uint32_t GetNeighborIndex(uint32_t index, uint8_t direction) const noexcept {
+      return index + static_cast<uint32_t>(m_DirectionOffsets[direction]);
+    }
+
+    inline Coords GetCoords(uint32_t index) const noexcept {
+      return Coords{
+        .x = static_cast<int32_t>(index % m_StrideY),
+        .y = static_cast<int32_t>((index % m_StrideZ) / m_StrideY),
+        .z = static_cast<int32_t>(index / m_StrideZ)
+      };
+    }
+
+    inline const Coords& GetExtent() const noexcept { return m_Extent; }
+    inline uint32_t GetStrideY() const noexcept { return m_StrideY; }
+    inline uint32_t GetStrideZ() const noexcept { return m_StrideZ; }
+    inline uint32_t GetCellCount() const noexcept { return m_CellCount; }
+
+    inline const std::vector<uint64_t>& GetWords() const noexcept { return m_Words; }
+
+  private:
+    Coords m_Extent{ 0, 0, 0 };
+    uint32_t m_StrideY = 0;
+    uint32_t m_StrideZ = 0;
+    uint32_t m_CellCount = 0;
+    std::array<int32_t, DIRECTIONS.size()> m_DirectionOffsets{};
+
+    std::vector<uint64_t> m_Words;
+  };
+}
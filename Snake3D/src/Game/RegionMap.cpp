@@ -0,0 +1,154 @@
+#include "RegionMap.h"
+
+namespace Snake {
+  // Cells of the 3x3x3 cube around a position are bits (x + 1) + (y + 1) * 3 + (z + 1) * 9
+  constexpr uint32_t CUBE_CENTER_BIT = 13;
+  constexpr uint32_t CUBE_FACE_NEIGHBORS = (1u << 12) | (1u << 14) | (1u << 10) | (1u << 16) | (1u << 4) | (1u << 22);
+
+  static constexpr uint32_t GetCubeLayerMask(uint32_t stride, uint32_t layer) noexcept {
+    uint32_t mask = 0;
+    for (uint32_t bit = 0; bit < 27; ++bit) {
+      if ((bit / stride) % 3 == layer) { mask |= 1u << bit; }
+    }
+
+    return mask;
+  }
+
+  constexpr uint32_t CUBE_X_LOW = GetCubeLayerMask(1, 0);
+  constexpr uint32_t CUBE_X_HIGH = GetCubeLayerMask(1, 2);
+  constexpr uint32_t CUBE_Y_LOW = GetCubeLayerMask(3, 0);
+  constexpr uint32_t CUBE_Y_HIGH = GetCubeLayerMask(3, 2);
+
+  void RegionMap::Update(const WorldModel& world) {
+    const OccupancyGrid& obstacles = world.GetObstacles();
+    m_WasRelabeled = false;
+
+    if (m_Obstacles != &obstacles || m_CellNodes.size() != obstacles.GetCellCount() || world.WasRebuilt()) {
+      m_Obstacles = &obstacles;
+      m_NeedsRelabel = true;
+    }
+
+    if (!m_NeedsRelabel) {
+      // A cell can be listed twice when it flipped back within the tick, only its final state counts.
+      // Blocked cells go first so the local test of each one sees only cells that were connected before.
+      const std::vector<uint32_t>& changedCells = world.GetChangedCells();
+      for (uint32_t index : changedCells) {
+        if (obstacles.Test(index) && m_CellNodes[index] != INVALID_NODE) { Block(index); }
+      }
+
+      for (uint32_t index : changedCells) {
+        if (!obstacles.Test(index) && m_CellNodes[index] == INVALID_NODE) { Free(index); }
+      }
+
+      // Every freed cell adds a node, the pool is compacted once it holds as many stale nodes as cells
+      if (m_Parents.size() > static_cast<uint64_t>(obstacles.GetCellCount()) * 2) {
+        m_NeedsRelabel = true;
+      }
+    }
+
+    if (m_NeedsRelabel) {
+      Relabel();
+      m_NeedsRelabel = false;
+      m_WasRelabeled = true;
+    }
+  }
+
+  void RegionMap::Relabel() {
+    const OccupancyGrid& obstacles = *m_Obstacles;
+    uint32_t cellCount = obstacles.GetCellCount();
+    m_CellNodes.assign(cellCount, INVALID_NODE);
+    m_Parents.resize(cellCount);
+    m_Sizes.assign(cellCount, 0);
+
+    for (uint32_t index = 0; index < cellCount; ++index) {
+      m_Parents[index] = index;
+      if (obstacles.Test(index)) { continue; }
+
+      m_CellNodes[index] = index;
+      m_Sizes[index] = 1;
+    }
+
+    // Each free cell joins its free neighbors with lower indices, that covers every edge once
+    const Coords& extent = obstacles.GetExtent();
+    uint32_t index = 0;
+    for (int32_t z = 0; z < extent.z; ++z) {
+      for (int32_t y = 0; y < extent.y; ++y) {
+        for (int32_t x = 0; x < extent.x; ++x, ++index) {
+          if (m_CellNodes[index] == INVALID_NODE) { continue; }
+
+          if (x > 0 && m_CellNodes[index - 1] != INVALID_NODE) { Union(index, index - 1); }
+          if (y > 0 && m_CellNodes[index - obstacles.GetStrideY()] != INVALID_NODE) { Union(index, index - obstacles.GetStrideY()); }
+          if (z > 0 && m_CellNodes[index - obstacles.GetStrideZ()] != INVALID_NODE) { Union(index, index - obstacles.GetStrideZ()); }
+        }
+      }
+    }
+  }
+
+  void RegionMap::Block(uint32_t index) {
+    uint32_t node = m_CellNodes[index];
+    --m_Sizes[Find(node)];
+
+    // The node stays in the tree, other nodes may still lead to the root through it
+    m_CellNodes[index] = INVALID_NODE;
+
+    if (!IsLocallyConnected(m_Obstacles->GetCoords(index))) {
+      m_NeedsRelabel = true;
+    }
+  }
+
+  void RegionMap::Free(uint32_t index) {
+    // The old node of the cell may still belong to a region the cell is no longer next to
+    uint32_t node = static_cast<uint32_t>(m_Parents.size());
+    m_Parents.push_back(node);
+    m_Sizes.push_back(1);
+    m_CellNodes[index] = node;
+
+    Coords pos = m_Obstacles->GetCoords(index);
+    for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+      if (IsMember(pos + DIRECTIONS[i])) {
+        Union(node, m_CellNodes[m_Obstacles->GetNeighborIndex(index, i)]);
+      }
+    }
+  }
+
+  bool RegionMap::IsLocallyConnected(const Coords& pos) const noexcept {
+    uint32_t members = 0;
+    for (int32_t z = -1; z <= 1; ++z) {
+      for (int32_t y = -1; y <= 1; ++y) {
+        for (int32_t x = -1; x <= 1; ++x) {
+          uint32_t bit = static_cast<uint32_t>((x + 1) + (y + 1) * 3 + (z + 1) * 9);
+          if (bit != CUBE_CENTER_BIT && IsMember(pos + Coords{ x, y, z })) { members |= 1u << bit; }
+        }
+      }
+    }
+
+    uint32_t faces = members & CUBE_FACE_NEIGHBORS;
+    if (std::popcount(faces) <= 1) { return true; }
+
+    // Grow from one face neighbor through member cells of the cube until it stops changing
+    uint32_t reached = faces & (~faces + 1);
+    for (;;) {
+      uint32_t grown = reached
+        | ((reached & ~CUBE_X_HIGH) << 1) | ((reached & ~CUBE_X_LOW) >> 1)
+        | ((reached & ~CUBE_Y_HIGH) << 3) | ((reached & ~CUBE_Y_LOW) >> 3)
+        | (reached << 9) | (reached >> 9);
+      grown &= members;
+
+      if (grown == reached) { break; }
+      reached = grown;
+    }
+
+    return (faces & ~reached) == 0;
+  }
+
+  void RegionMap::Union(uint32_t lhs, uint32_t rhs) noexcept {
+    lhs = Find(lhs);
+    rhs = Find(rhs);
+    if (lhs == rhs) { return; }
+
+    if (m_Sizes[lhs] < m_Sizes[rhs]) { std::swap(lhs, rhs); }
+
+    m_Parents[rhs] = lhs;
+    m_Sizes[lhs] += m_Sizes[rhs];
+  }
+}
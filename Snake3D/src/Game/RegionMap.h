@@ -0,0 +1,67 @@
+#pragma once
+
+#include "WorldModel.h"
+
+namespace Snake {
+  // Connected regions of free cells kept in a union-find across ticks.
+  // Freed cells get a fresh node and are merged with their free neighbors. A blocked cell only shrinks its region
+  // when its free neighbors stay connected around it inside the surrounding 3x3x3 cube, otherwise the region
+  // might have split and everything is relabeled from scratch.
+  class RegionMap {
+  public:
+    RegionMap() = default;
+
+    // Follows the changed cells of the world model, must run before any query of the tick
+    void Update(const WorldModel& world);
+
+    // Number of free cells connected to the position, zero for blocked cells and cells outside of the map
+    inline uint32_t GetRegionSize(const Coords& pos) const noexcept {
+      if (m_Obstacles == nullptr || !m_Obstacles->IsInside(pos)) { return 0; }
+
+      uint32_t node = m_CellNodes[m_Obstacles->GetIndex(pos)];
+      return node == INVALID_NODE ? 0 : m_Sizes[FindRoot(node)];
+    }
+
+    inline bool WasRelabeled() const noexcept { return m_WasRelabeled; }
+
+  private:
+    static constexpr uint32_t INVALID_NODE = std::numeric_limits<uint32_t>::max();
+
+    void Relabel();
+    void Block(uint32_t index);
+    void Free(uint32_t index);
+
+    bool IsLocallyConnected(const Coords& pos) const noexcept;
+
+    inline bool IsMember(const Coords& pos) const noexcept {
+      return m_Obstacles->IsInside(pos) && m_CellNodes[m_Obstacles->GetIndex(pos)] != INVALID_NODE;
+    }
+
+    // Union by size keeps trees shallow, so queries from several workers can walk them without compressing
+    inline uint32_t FindRoot(uint32_t node) const noexcept {
+      while (m_Parents[node] != node) { node = m_Parents[node]; }
+      return node;
+    }
+
+    inline uint32_t Find(uint32_t node) noexcept {
+      while (m_Parents[node] != node) {
+        m_Parents[node] = m_Parents[m_Parents[node]];
+        node = m_Parents[node];
+      }
+
+      return node;
+    }
+
+    void Union(uint32_t lhs, uint32_t rhs) noexcept;
+
+  private:
+    const OccupancyGrid* m_Obstacles = nullptr;
+
+    std::vector<uint32_t> m_CellNodes;
+    std::vector<uint32_t> m_Parents;
+    std::vector<uint32_t> m_Sizes;
+
+    bool m_NeedsRelabel = true;
+    bool m_WasRelabeled = false;
+  };
+}
@@ -0,0 +1,174 @@
+#include "RolloutEvaluator.h"
+
+namespace Snake {
+  // Ticks simulated per rollout, enemy moves further out are mostly noise
+  constexpr uint32_t ROLLOUT_DEPTH = 16;
+
+  // Upper bound on rollouts per direction, each direction is split into batches so idle slots can pick up work
+  constexpr uint32_t ROLLOUTS_PER_MOVE = 256;
+  constexpr uint32_t ROLLOUT_BATCHES = 4;
+
+  // Value lost by dying, food is worth its points
+  constexpr int64_t DEATH_PENALTY = 100;
+
+  // Fewer rollouts than this say nothing about a direction
+  constexpr uint32_t MIN_DECISION_ROLLOUTS = 16;
+
+  // The planned move is only replaced when another direction survives this much more often
+  constexpr float SURVIVAL_TOLERANCE = 0.1f;
+
+  // Chance in percent that a simulated snake keeps going straight while it can
+  constexpr uint32_t KEEP_DIRECTION_PERCENT = 60;
+
+  void RolloutEvaluator::Evaluate(const Simulator& simulator, const std::vector<uint8_t>& plannedMoves, Utils::ThreadPool& pool,
+                                  const Utils::Deadline& deadline) {
+    auto startTime = std::chrono::steady_clock::now();
+    const SimState& initialState = simulator.GetInitialState();
+
+    uint32_t snakeCount = static_cast<uint32_t>(std::min<uint64_t>(plannedMoves.size(), initialState.GetSnakeCount()));
+    m_Stats.assign(static_cast<uint64_t>(snakeCount) * DIRECTIONS.size(), MoveStats{});
+    m_RolloutCount = 0;
+    m_ElapsedSec = 0.0;
+
+    for (uint32_t i = 0; i < snakeCount; ++i) {
+      for (uint8_t move = 0; move < DIRECTIONS.size(); ++move) {
+        m_Stats[i * DIRECTIONS.size() + move].isSafe = simulator.IsMoveSafe(initialState, i, move);
+      }
+    }
+
+    // Tasks go batch by batch, so an evaluation cut short by the deadline still leaves every direction some rollouts
+    m_Tasks.clear();
+    for (uint32_t batch = 0; batch < ROLLOUT_BATCHES; ++batch) {
+      for (uint32_t i = 0; i < snakeCount; ++i) {
+        for (uint8_t move = 0; move < DIRECTIONS.size(); ++move) {
+          if (m_Stats[i * DIRECTIONS.size() + move].isSafe) {
+            m_Tasks.push_back(Task{ i, move });
+          }
+        }
+      }
+    }
+
+    if (m_Tasks.empty()) { return; }
+
+    if (m_Arenas.size() != pool.GetSlotCount()) {
+      m_Arenas = std::vector<SlotArena>(pool.GetSlotCount());
+    }
+
+    // Every slot draws from its own stream, reseeded per tick so ticks do not replay each other
+    for (SlotArena& arena : m_Arenas) {
+      m_Seed += 0x9E3779B97F4A7C15ull;
+      arena.random.state = m_Seed | 1;
+      arena.moves.resize(initialState.GetSnakeCount());
+      arena.isSynced = false;
+    }
+
+    m_TaskStats.assign(m_Tasks.size(), MoveStats{});
+    pool.ParallelFor(static_cast<uint32_t>(m_Tasks.size()), [this, &simulator, &plannedMoves, &deadline](uint32_t index, uint32_t slot) {
+      const Task& task = m_Tasks[index];
+      MoveStats& stats = m_TaskStats[index];
+      SlotArena& arena = m_Arenas[slot];
+      if (!arena.isSynced) {
+        arena.state.CopyFrom(simulator.GetInitialState());
+        arena.isSynced = true;
+      }
+
+      for (uint32_t i = 0; i < ROLLOUTS_PER_MOVE / ROLLOUT_BATCHES && !deadline.IsExpired(); ++i) {
+        auto [value, survived] = RunRollout(simulator, plannedMoves, task, arena);
+        ++stats.rollouts;
+        stats.survived += survived;
+        stats.value += value;
+      }
+    });
+
+    for (uint64_t i = 0; i < m_Tasks.size(); ++i) {
+      MoveStats& stats = m_Stats[m_Tasks[i].snakeIndex * DIRECTIONS.size() + m_Tasks[i].move];
+      stats.rollouts += m_TaskStats[i].rollouts;
+      stats.survived += m_TaskStats[i].survived;
+      stats.value += m_TaskStats[i].value;
+      m_RolloutCount += m_TaskStats[i].rollouts;
+    }
+
+    m_ElapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  }
+
+  uint8_t RolloutEvaluator::ChooseMove(uint32_t snakeIndex, uint8_t plannedMove) const {
+    if ((snakeIndex + 1) * DIRECTIONS.size() > m_Stats.size()) { return plannedMove; }
+
+    return SelectMove(std::span<const MoveStats>(m_Stats).subspan(snakeIndex * DIRECTIONS.size(), DIRECTIONS.size()), plannedMove);
+  }
+
+  uint8_t RolloutEvaluator::SelectMove(std::span<const MoveStats> stats, uint8_t plannedMove) noexcept {
+    const MoveStats* planned = plannedMove < stats.size() ? &stats[plannedMove] : nullptr;
+
+    // The deadline cut a safe planned move short, there is nothing to weigh the other directions against
+    if (planned && planned->isSafe && planned->rollouts < MIN_DECISION_ROLLOUTS) { return plannedMove; }
+
+    uint8_t bestMove = Simulator::NO_MOVE;
+    float bestSurvival = 0.0f;
+    float bestValue = 0.0f;
+    for (uint8_t move = 0; move < stats.size(); ++move) {
+      if (stats[move].rollouts < MIN_DECISION_ROLLOUTS) { continue; }
+
+      float survival = stats[move].GetSurvivalRate();
+      float value = stats[move].GetMeanValue();
+      if (bestMove == Simulator::NO_MOVE || survival > bestSurvival || (survival == bestSurvival && value > bestValue)) {
+        bestMove = move;
+        bestSurvival = survival;
+        bestValue = value;
+      }
+    }
+
+    if (bestMove == Simulator::NO_MOVE) { return plannedMove; }
+
+    // A planned move into a wall or body is never simulated and always loses to a safe one
+    if (planned && planned->isSafe && planned->GetSurvivalRate() + SURVIVAL_TOLERANCE >= bestSurvival) { return plannedMove; }
+
+    return bestMove;
+  }
+
+  std::pair<int64_t, bool> RolloutEvaluator::RunRollout(const Simulator& simulator, const std::vector<uint8_t>& plannedMoves,
+                                                        const Task& task, SlotArena& arena) const {
+    SimState& state = arena.state;
+    state.RestoreFrom(simulator.GetInitialState());
+
+    uint32_t snakeCount = state.GetSnakeCount();
+    int32_t startScore = state.GetSnake(task.snakeIndex).score;
+
+    for (uint32_t depth = 0; depth < ROLLOUT_DEPTH; ++depth) {
+      for (uint32_t i = 0; i < snakeCount; ++i) {
+        arena.moves[i] = depth == 0 && i < plannedMoves.size() ? plannedMoves[i] : PickMove(simulator, state, i, arena.random);
+      }
+
+      if (depth == 0) {
+        arena.moves[task.snakeIndex] = task.move;
+      }
+
+      simulator.Step(state, arena.moves.data());
+
+      const SimState::SnakeState& snake = state.GetSnake(task.snakeIndex);
+      if (!snake.isAlive) {
+        return { snake.score - startScore - DEATH_PENALTY, false };
+      }
+    }
+
+    return { state.GetSnake(task.snakeIndex).score - startScore, true };
+  }
+
+  uint8_t RolloutEvaluator::PickMove(const Simulator& simulator, const SimState& state, uint32_t snakeIndex, Random& random) noexcept {
+    const SimState::SnakeState& snake = state.GetSnake(snakeIndex);
+    if (!snake.isAlive) { return Simulator::NO_MOVE; }
+
+    if (random.Below(100) < KEEP_DIRECTION_PERCENT && simulator.IsMoveSafe(state, snakeIndex, snake.direction)) {
+      return snake.direction;
+    }
+
+    // Any safe direction, starting from a random one. Trapped snakes keep going and die.
+    uint32_t offset = random.Below(static_cast<uint32_t>(DIRECTIONS.size()));
+    for (uint32_t i = 0; i < DIRECTIONS.size(); ++i) {
+      uint8_t move = static_cast<uint8_t>((offset + i) % DIRECTIONS.size());
+      if (simulator.IsMoveSafe(state, snakeIndex, move)) { return move; }
+    }
+
+    return snake.direction;
+  }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Simulator.h"
+
+#include "Utils/Deadline.h"
+#include "Utils/ThreadPool.h"
+
+#include <span>
+
+namespace Snake {
+  // Flat Monte-Carlo check of the first move of each of our snakes. Every safe direction is scored by short randomized
+  // simulations, spread over the planner pool with one simulation state and random generator per slot.
+  class RolloutEvaluator {
+  public:
+    struct MoveStats {
+      uint32_t rollouts = 0;
+      uint32_t survived = 0;
+      int64_t value = 0;
+      // Set for every direction that does not run into a wall or body on the first tick, simulated or not
+      bool isSafe = false;
+
+      inline float GetSurvivalRate() const noexcept { return rollouts == 0 ? 0.0f : static_cast<float>(survived) / static_cast<float>(rollouts); }
+      inline float GetMeanValue() const noexcept { return rollouts == 0 ? 0.0f : static_cast<float>(value) / static_cast<float>(rollouts); }
+    };
+
+    RolloutEvaluator() = default;
+
+    // Plays the planned moves of our snakes on the first tick, except for the direction being scored.
+    // Runs until every direction got its rollouts or the deadline expires.
+    void Evaluate(const Simulator& simulator, const std::vector<uint8_t>& plannedMoves, Utils::ThreadPool& pool,
+                  const Utils::Deadline& deadline);
+
+    // Keeps the planned move unless it is blocked or another direction survives clearly more often
+    uint8_t ChooseMove(uint32_t snakeIndex, uint8_t plannedMove) const;
+
+    // Decides from the stats of every direction of one snake. Candidates rank by survival rate, value only breaks ties.
+    static uint8_t SelectMove(std::span<const MoveStats> stats, uint8_t plannedMove) noexcept;
+
+    inline const MoveStats& GetStats(uint32_t snakeIndex, uint8_t move) const noexcept {
+      return m_Stats[snakeIndex * DIRECTIONS.size() + move];
+    }
+
+    inline uint64_t GetRolloutCount() const noexcept { return m_RolloutCount; }
+    inline double GetRolloutsPerSecond() const noexcept { return m_ElapsedSec > 0.0 ? static_cast<double>(m_RolloutCount) / m_ElapsedSec : 0.0; }
+
+  private:
+    // xorshift64*, good enough for picking moves and cheap enough to call every step
+    struct Random {
+      uint64_t state = 1;
+
+      inline uint64_t Next() noexcept {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1Dull;
+      }
+
+      inline uint32_t Below(uint32_t bound) noexcept { return static_cast<uint32_t>((Next() >> 32) * bound >> 32); }
+    };
+
+    // The state is copied from the initial state once per evaluation, rollouts after the first only restore what they wrote
+    struct alignas(Utils::CACHE_LINE_SIZE) SlotArena {
+      SimState state;
+      std::vector<uint8_t> moves;
+      Random random;
+      bool isSynced = false;
+    };
+
+    struct Task {
+      uint32_t snakeIndex = 0;
+      uint8_t move = 0;
+    };
+
+    // Returns the value of one rollout for the scored snake, and whether it was still alive at the end
+    std::pair<int64_t, bool> RunRollout(const Simulator& simulator, const std::vector<uint8_t>& plannedMoves, const Task& task,
+                                        SlotArena& arena) const;
+
+    static uint8_t PickMove(const Simulator& simulator, const SimState& state, uint32_t snakeIndex, Random& random) noexcept;
+
+  private:
+    std::vector<SlotArena> m_Arenas;
+    std::vector<Task> m_Tasks;
+    std::vector<MoveStats> m_TaskStats;
+    std::vector<MoveStats> m_Stats;
+
+    uint64_t m_Seed = 0x9E3779B97F4A7C15ull;
+    uint64_t m_RolloutCount = 0;
+    double m_ElapsedSec = 0.0;
+  };
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "pch.h"
+
+#include "OccupancyGrid.h"
+
+#include "Utils/RingQueue.h"
+
+namespace Snake {
+  struct Cell {
+    Coords pos{ 0, 0, 0 };
+    uint32_t index = 0;
+  };
+
+  struct WeightedCell {
+    Cell cell;
+    float score = 0.0f;
+
+    inline bool operator<(const WeightedCell& other) const {
+      return score < other.score;
+    }
+  };
+
+  // Per-thread search buffers that persist across ticks.
+  // Visited cells are tracked with generation stamps, so starting a new search is O(1).
+  struct SearchScratch {
+    static constexpr uint8_t NO_MOVE = std::numeric_limits<uint8_t>::max();
+
+    std::vector<uint32_t> visitedStamps;
+    std::vector<uint8_t> firstMoves;
+    std::vector<uint8_t> arrivalMoves;
+    std::vector<uint32_t> costs;
+    std::vector<uint32_t> steps;
+    Utils::RingQueue<uint32_t> frontier;
+    std::vector<WeightedCell> heap;
+    std::vector<std::pair<float, uint32_t>> targets;
+    std::vector<uint32_t> pathCells;
+    uint32_t generation = 0;
+
+    // Sector-local searches and the abstract search over sector portals, sized by SectorGraph
+    std::vector<uint16_t> sectorDistances;
+    Utils::RingQueue<uint32_t> sectorFrontier;
+    std::vector<uint16_t> startPortalDistances;
+    std::vector<uint16_t> goalPortalDistances;
+    std::vector<uint32_t> portalStamps;
+    std::vector<uint32_t> portalCosts;
+    std::vector<uint32_t> portalWaypoints;
+    std::vector<std::pair<float, uint32_t>> portalHeap;
+    uint32_t portalGeneration = 0;
+
+    // Set by searches that stopped because the deadline expired
+    bool wasCutShort = false;
+
+    // Sizes the buffers for the given grid and starts a new search generation
+    void Prepare(uint32_t cellCount) {
+      if (visitedStamps.size() != cellCount) {
+        visitedStamps.assign(cellCount, 0);
+        firstMoves.assign(cellCount, NO_MOVE);
+        arrivalMoves.assign(cellCount, NO_MOVE);
+        costs.assign(cellCount, 0);
+        steps.assign(cellCount, 0);
+        frontier.Reserve(cellCount);
+        generation = 0;
+      }
+
+      frontier.Clear();
+      heap.clear();
+
+      if (++generation == 0) {
+        std::fill(visitedStamps.begin(), visitedStamps.end(), 0);
+        generation = 1;
+      }
+    }
+
+    inline bool IsVisited(uint32_t index) const noexcept { return visitedStamps[index] == generation; }
+
+    inline void Visit(uint32_t index, uint8_t firstMove) noexcept {
+      visitedStamps[index] = generation;
+      firstMoves[index] = firstMove;
+    }
+
+    inline void Visit(uint32_t index, uint8_t firstMove, uint32_t cost, uint8_t arrivalMove, uint32_t stepCount) noexcept {
+      Visit(index, firstMove);
+      costs[index] = cost;
+      arrivalMoves[index] = arrivalMove;
+      steps[index] = stepCount;
+    }
+
+    // Follows the arrival moves of the last weighted search back from the target.
+    // Cells are written from the first step to the target, the start cell is left out.
+    void ExtractPath(uint32_t target, const OccupancyGrid& grid, std::vector<uint32_t>& path) const {
+      path.clear();
+      for (uint32_t index = target; arrivalMoves[index] != NO_MOVE; index = grid.GetNeighborIndex(index, GetOppositeDirection(arrivalMoves[index]))) {
+        path.push_back(index);
+      }
+
+      std::reverse(path.begin(), path.end());
+    }
+  };
+}
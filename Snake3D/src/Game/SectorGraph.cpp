@@ -0,0 +1,413 @@
+#include "SectorGraph.h"
+
+namespace Snake {
+  // Cells of one sector, the size of the sector-local search buffers
+  constexpr uint32_t SECTOR_CELL_COUNT = SECTOR_SIZE * SECTOR_SIZE * SECTOR_SIZE;
+
+  // Only the largest open regions of a face become portals. Rebuild cost grows with the square of the portals per sector,
+  // and on cluttered faces the small regions are mostly single-cell holes the detailed search handles anyway.
+  constexpr uint32_t MAX_FACE_PORTALS = 8;
+
+  static inline int32_t& GetAxis(Coords& pos, uint32_t axis) noexcept {
+    return axis == 0 ? pos.x : (axis == 1 ? pos.y : pos.z);
+  }
+
+  static inline int32_t GetAxis(const Coords& pos, uint32_t axis) noexcept {
+    return axis == 0 ? pos.x : (axis == 1 ? pos.y : pos.z);
+  }
+
+  void SectorGraph::Update(const OccupancyGrid& obstacles) {
+    m_Obstacles = &obstacles;
+
+    for (uint32_t sector : m_DirtySectors) {
+      m_IsDirty[sector] = false;
+    }
+    m_DirtySectors.clear();
+
+    auto markDirty = [this](uint32_t sector) {
+      if (sector == INVALID_SECTOR || m_IsDirty[sector]) { return; }
+
+      m_IsDirty[sector] = true;
+      m_DirtySectors.push_back(sector);
+    };
+
+    if (!(obstacles.GetExtent() == m_Extent) || m_Snapshot.empty()) {
+      Reset(obstacles);
+      for (uint32_t i = 0; i < m_Sectors.size(); ++i) {
+        markDirty(i);
+      }
+    } else {
+      // Only sectors with a flipped bit are touched
+      const std::vector<uint64_t>& words = obstacles.GetWords();
+      for (uint64_t i = 0; i < words.size(); ++i) {
+        for (uint64_t changed = words[i] ^ m_Snapshot[i]; changed != 0; changed &= changed - 1) {
+          uint32_t index = static_cast<uint32_t>(i * 64) + static_cast<uint32_t>(std::countr_zero(changed));
+          markDirty(GetSectorIndex(obstacles.GetCoords(index)));
+        }
+      }
+
+      m_Snapshot.assign(words.begin(), words.end());
+    }
+
+    if (m_DirtySectors.empty()) { return; }
+
+    // Faces touching a changed sector are traced again. Sectors behind a face that gained or lost
+    // portals get a new portal list and have to be rebuilt as well.
+    uint64_t changedSectorCount = m_DirtySectors.size();
+    for (uint64_t i = 0; i < changedSectorCount; ++i) {
+      uint32_t sector = m_DirtySectors[i];
+      for (uint32_t axis = 0; axis < 3; ++axis) {
+        if (RebuildFace(sector, axis)) {
+          markDirty(GetNeighborSector(sector, axis, 1));
+        }
+
+        uint32_t previous = GetNeighborSector(sector, axis, -1);
+        if (previous != INVALID_SECTOR && RebuildFace(previous, axis)) {
+          markDirty(previous);
+        }
+      }
+    }
+
+    AssignPortals();
+  }
+
+  void SectorGraph::RebuildSector(uint32_t sector, SearchScratch& scratch) {
+    Sector& current = m_Sectors[sector];
+    uint32_t portalCount = current.portalCount;
+    current.distances.assign(static_cast<uint64_t>(portalCount) * portalCount, UNREACHABLE);
+
+    for (uint32_t i = 0; i < portalCount; ++i) {
+      ComputeSectorDistances(current, m_Portals[current.firstPortal + i].pos, scratch);
+
+      for (uint32_t j = 0; j < portalCount; ++j) {
+        const Portal& portal = m_Portals[current.firstPortal + j];
+        current.distances[i * portalCount + j] = scratch.sectorDistances[GetLocalIndex(current, portal.pos)];
+      }
+    }
+  }
+
+  std::optional<SectorGraph::Route> SectorGraph::FindRoute(const Coords& start, const Coords& goal, SearchScratch& scratch) const {
+    if (m_Sectors.empty() || !m_Obstacles->IsInside(start) || !m_Obstacles->IsInside(goal)) { return std::nullopt; }
+
+    uint32_t startSectorIndex = GetSectorIndex(start);
+    uint32_t goalSectorIndex = GetSectorIndex(goal);
+    if (startSectorIndex == goalSectorIndex) { return std::nullopt; }
+
+    // Connect both ends to the portals of their sectors
+    const Sector& goalSector = m_Sectors[goalSectorIndex];
+    ComputeSectorDistances(goalSector, goal, scratch);
+    scratch.goalPortalDistances.resize(goalSector.portalCount);
+    for (uint32_t i = 0; i < goalSector.portalCount; ++i) {
+      scratch.goalPortalDistances[i] = scratch.sectorDistances[GetLocalIndex(goalSector, m_Portals[goalSector.firstPortal + i].pos)];
+    }
+
+    const Sector& startSector = m_Sectors[startSectorIndex];
+    ComputeSectorDistances(startSector, start, scratch);
+    scratch.startPortalDistances.resize(startSector.portalCount);
+    for (uint32_t i = 0; i < startSector.portalCount; ++i) {
+      scratch.startPortalDistances[i] = scratch.sectorDistances[GetLocalIndex(startSector, m_Portals[startSector.firstPortal + i].pos)];
+    }
+
+    // The goal is one extra node after the portals
+    uint32_t goalNode = static_cast<uint32_t>(m_Portals.size());
+    if (scratch.portalStamps.size() != m_Portals.size() + 1) {
+      scratch.portalStamps.assign(m_Portals.size() + 1, 0);
+      scratch.portalCosts.assign(m_Portals.size() + 1, 0);
+      scratch.portalWaypoints.assign(m_Portals.size() + 1, 0);
+      scratch.portalGeneration = 0;
+    }
+
+    if (++scratch.portalGeneration == 0) {
+      std::fill(scratch.portalStamps.begin(), scratch.portalStamps.end(), 0);
+      scratch.portalGeneration = 1;
+    }
+
+    uint32_t generation = scratch.portalGeneration;
+    scratch.portalHeap.clear();
+
+    auto getHeuristic = [this, goalNode, &goal](uint32_t node) {
+      return node == goalNode ? 0.0f : static_cast<float>(GetManhattanDistance(m_Portals[node].pos, goal));
+    };
+
+    // std heap functions build a max-heap, invert the order to pop the lowest score first
+    auto compare = [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; };
+
+    auto relax = [&scratch, &getHeuristic, &compare, generation](uint32_t node, uint32_t cost, uint32_t waypoint) {
+      if (scratch.portalStamps[node] == generation && scratch.portalCosts[node] <= cost) { return; }
+
+      scratch.portalStamps[node] = generation;
+      scratch.portalCosts[node] = cost;
+      scratch.portalWaypoints[node] = waypoint;
+      scratch.portalHeap.emplace_back(static_cast<float>(cost) + getHeuristic(node), node);
+      std::push_heap(scratch.portalHeap.begin(), scratch.portalHeap.end(), compare);
+    };
+
+    for (uint32_t i = 0; i < startSector.portalCount; ++i) {
+      uint16_t distance = scratch.startPortalDistances[i];
+      if (distance != UNREACHABLE) {
+        relax(startSector.firstPortal + i, distance, startSector.firstPortal + i);
+      }
+    }
+
+    uint32_t startIndex = m_Obstacles->GetIndex(start);
+    while (!scratch.portalHeap.empty()) {
+      std::pop_heap(scratch.portalHeap.begin(), scratch.portalHeap.end(), compare);
+      auto [score, node] = scratch.portalHeap.back();
+      scratch.portalHeap.pop_back();
+
+      uint32_t cost = scratch.portalCosts[node];
+
+      // Skip entries that were superseded by a cheaper path
+      if (score > static_cast<float>(cost) + getHeuristic(node)) { continue; }
+
+      uint32_t waypoint = scratch.portalWaypoints[node];
+      if (node == goalNode) {
+        const Portal& exit = m_Portals[waypoint];
+        uint32_t waypointDistance = exit.sector == startSectorIndex ? scratch.startPortalDistances[waypoint - startSector.firstPortal] : 1;
+        return Route{ .waypoint = exit.cell, .waypointDistance = waypointDistance, .length = cost };
+      }
+
+      // A start lying on a portal moves the waypoint to the next portal of the route
+      bool isWaypointAtStart = m_Portals[waypoint].cell == startIndex;
+
+      const Portal& portal = m_Portals[node];
+      const Sector& sector = m_Sectors[portal.sector];
+      uint32_t localIndex = node - sector.firstPortal;
+
+      if (portal.sector == goalSectorIndex) {
+        uint16_t distance = scratch.goalPortalDistances[localIndex];
+        if (distance != UNREACHABLE) {
+          relax(goalNode, cost + distance, isWaypointAtStart ? node : waypoint);
+        }
+      }
+
+      relax(portal.peer, cost + 1, isWaypointAtStart ? portal.peer : waypoint);
+
+      for (uint32_t i = 0; i < sector.portalCount; ++i) {
+        uint16_t distance = sector.distances[localIndex * sector.portalCount + i];
+        if (i == localIndex || distance == UNREACHABLE) { continue; }
+
+        uint32_t next = sector.firstPortal + i;
+        relax(next, cost + distance, isWaypointAtStart ? next : waypoint);
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  void SectorGraph::Reset(const OccupancyGrid& obstacles) {
+    m_Extent = obstacles.GetExtent();
+    m_SectorCounts = Coords{
+      static_cast<int32_t>((static_cast<uint32_t>(m_Extent.x) + SECTOR_SIZE - 1) / SECTOR_SIZE),
+      static_cast<int32_t>((static_cast<uint32_t>(m_Extent.y) + SECTOR_SIZE - 1) / SECTOR_SIZE),
+      static_cast<int32_t>((static_cast<uint32_t>(m_Extent.z) + SECTOR_SIZE - 1) / SECTOR_SIZE)
+    };
+
+    const std::vector<uint64_t>& words = obstacles.GetWords();
+    m_Snapshot.assign(words.begin(), words.end());
+
+    uint32_t sectorCount = static_cast<uint32_t>(m_SectorCounts.x * m_SectorCounts.y * m_SectorCounts.z);
+    m_Sectors.assign(sectorCount, Sector{});
+    m_Faces.assign(static_cast<uint64_t>(sectorCount) * 3, Face{});
+    m_Portals.clear();
+    m_IsDirty.assign(sectorCount, false);
+    m_DirtySectors.clear();
+
+    for (int32_t z = 0; z < m_SectorCounts.z; ++z) {
+      for (int32_t y = 0; y < m_SectorCounts.y; ++y) {
+        for (int32_t x = 0; x < m_SectorCounts.x; ++x) {
+          Coords min{ x * static_cast<int32_t>(SECTOR_SIZE), y * static_cast<int32_t>(SECTOR_SIZE), z * static_cast<int32_t>(SECTOR_SIZE) };
+          Sector& sector = m_Sectors[GetSectorIndex(min)];
+          sector.min = min;
+          sector.size = Coords{
+            std::min<int32_t>(SECTOR_SIZE, m_Extent.x - min.x),
+            std::min<int32_t>(SECTOR_SIZE, m_Extent.y - min.y),
+            std::min<int32_t>(SECTOR_SIZE, m_Extent.z - min.z)
+          };
+        }
+      }
+    }
+  }
+
+  bool SectorGraph::RebuildFace(uint32_t sector, uint32_t axis) {
+    Face& face = m_Faces[GetFaceIndex(sector, axis)];
+    std::vector<std::pair<uint32_t, uint32_t>> previous = std::move(face.portals);
+    face.portals.clear();
+
+    if (GetNeighborSector(sector, axis, 1) == INVALID_SECTOR) { return !previous.empty(); }
+
+    const Sector& current = m_Sectors[sector];
+    uint32_t axisU = (axis + 1) % 3;
+    uint32_t axisV = (axis + 2) % 3;
+    int32_t sizeU = GetAxis(current.size, axisU);
+    int32_t sizeV = GetAxis(current.size, axisV);
+
+    // The near cell lies on the last layer of this sector, the far cell on the first layer of the neighbor
+    auto getNearCell = [&current, axis, axisU, axisV](int32_t u, int32_t v) {
+      Coords pos = current.min;
+      GetAxis(pos, axis) += GetAxis(current.size, axis) - 1;
+      GetAxis(pos, axisU) += u;
+      GetAxis(pos, axisV) += v;
+      return pos;
+    };
+
+    Coords step{ 0, 0, 0 };
+    GetAxis(step, axis) = 1;
+
+    m_FaceCells.assign(static_cast<uint64_t>(sizeU) * sizeV, false);
+    for (int32_t v = 0; v < sizeV; ++v) {
+      for (int32_t u = 0; u < sizeU; ++u) {
+        Coords near = getNearCell(u, v);
+        m_FaceCells[u + v * sizeU] = !m_Obstacles->IsBlocked(near) && !m_Obstacles->IsBlocked(near + step);
+      }
+    }
+
+    // Every 4-connected open region becomes one portal pair, placed on the cell closest to its center
+    m_FaceRegions.clear();
+    for (int32_t start = 0; start < sizeU * sizeV; ++start) {
+      if (!m_FaceCells[start]) { continue; }
+
+      m_FaceCells[start] = false;
+      m_FaceStack.assign(1, start);
+      m_FaceRegion.clear();
+
+      int64_t sumU = 0;
+      int64_t sumV = 0;
+      while (!m_FaceStack.empty()) {
+        uint32_t cell = m_FaceStack.back();
+        m_FaceStack.pop_back();
+        m_FaceRegion.push_back(cell);
+
+        int32_t u = static_cast<int32_t>(cell) % sizeU;
+        int32_t v = static_cast<int32_t>(cell) / sizeU;
+        sumU += u;
+        sumV += v;
+
+        std::array<std::pair<int32_t, int32_t>, 4> neighbors{ { { u + 1, v }, { u - 1, v }, { u, v + 1 }, { u, v - 1 } } };
+        for (auto [nu, nv] : neighbors) {
+          if (nu < 0 || nv < 0 || nu >= sizeU || nv >= sizeV || !m_FaceCells[nu + nv * sizeU]) { continue; }
+
+          m_FaceCells[nu + nv * sizeU] = false;
+          m_FaceStack.push_back(static_cast<uint32_t>(nu + nv * sizeU));
+        }
+      }
+
+      int64_t regionSize = static_cast<int64_t>(m_FaceRegion.size());
+      auto getCenterDistance = [sizeU, sumU, sumV, regionSize](uint32_t cell) {
+        int64_t u = static_cast<int32_t>(cell) % sizeU;
+        int64_t v = static_cast<int32_t>(cell) / sizeU;
+        return std::abs(u * regionSize - sumU) + std::abs(v * regionSize - sumV);
+      };
+
+      uint32_t center = *std::min_element(m_FaceRegion.begin(), m_FaceRegion.end(), [&getCenterDistance](uint32_t lhs, uint32_t rhs) {
+        return getCenterDistance(lhs) < getCenterDistance(rhs);
+      });
+
+      m_FaceRegions.emplace_back(static_cast<uint32_t>(regionSize), center);
+    }
+
+    // Largest regions first, ties keep scan order so an unchanged face yields the same portals
+    std::stable_sort(m_FaceRegions.begin(), m_FaceRegions.end(), [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+    m_FaceRegions.resize(std::min<uint64_t>(m_FaceRegions.size(), MAX_FACE_PORTALS));
+
+    for (const auto& [regionSize, center] : m_FaceRegions) {
+      Coords near = getNearCell(static_cast<int32_t>(center) % sizeU, static_cast<int32_t>(center) / sizeU);
+      face.portals.emplace_back(m_Obstacles->GetIndex(near), m_Obstacles->GetIndex(near + step));
+    }
+
+    return face.portals != previous;
+  }
+
+  void SectorGraph::AssignPortals() {
+    m_Portals.clear();
+
+    // Portals of a sector only depend on its six faces, so untouched sectors keep their local order
+    for (uint32_t sector = 0; sector < m_Sectors.size(); ++sector) {
+      Sector& current = m_Sectors[sector];
+      current.firstPortal = static_cast<uint32_t>(m_Portals.size());
+
+      for (uint32_t axis = 0; axis < 3; ++axis) {
+        Face& face = m_Faces[GetFaceIndex(sector, axis)];
+        face.firstNearPortal = static_cast<uint32_t>(m_Portals.size());
+        for (const auto& [nearCell, farCell] : face.portals) {
+          m_Portals.push_back(Portal{ .pos = m_Obstacles->GetCoords(nearCell), .cell = nearCell, .sector = sector });
+        }
+      }
+
+      for (uint32_t axis = 0; axis < 3; ++axis) {
+        uint32_t previous = GetNeighborSector(sector, axis, -1);
+        if (previous == INVALID_SECTOR) { continue; }
+
+        Face& face = m_Faces[GetFaceIndex(previous, axis)];
+        face.firstFarPortal = static_cast<uint32_t>(m_Portals.size());
+        for (const auto& [nearCell, farCell] : face.portals) {
+          m_Portals.push_back(Portal{ .pos = m_Obstacles->GetCoords(farCell), .cell = farCell, .sector = sector });
+        }
+      }
+
+      current.portalCount = static_cast<uint32_t>(m_Portals.size()) - current.firstPortal;
+    }
+
+    for (const Face& face : m_Faces) {
+      for (uint32_t i = 0; i < face.portals.size(); ++i) {
+        m_Portals[face.firstNearPortal + i].peer = face.firstFarPortal + i;
+        m_Portals[face.firstFarPortal + i].peer = face.firstNearPortal + i;
+      }
+    }
+  }
+
+  void SectorGraph::ComputeSectorDistances(const Sector& sector, const Coords& from, SearchScratch& scratch) const {
+    if (scratch.sectorDistances.size() != SECTOR_CELL_COUNT) {
+      scratch.sectorDistances.resize(SECTOR_CELL_COUNT);
+      scratch.sectorFrontier.Reserve(SECTOR_CELL_COUNT);
+    }
+
+    std::fill(scratch.sectorDistances.begin(), scratch.sectorDistances.end(), UNREACHABLE);
+    scratch.sectorFrontier.Clear();
+
+    if (m_Obstacles->IsBlocked(from)) { return; }
+
+    scratch.sectorDistances[GetLocalIndex(sector, from)] = 0;
+    scratch.sectorFrontier.Push(GetLocalIndex(sector, from));
+
+    while (!scratch.sectorFrontier.IsEmpty()) {
+      uint32_t localIndex = scratch.sectorFrontier.Pop();
+      uint16_t distance = scratch.sectorDistances[localIndex];
+      Coords local{
+        static_cast<int32_t>(localIndex % SECTOR_SIZE),
+        static_cast<int32_t>(localIndex / SECTOR_SIZE % SECTOR_SIZE),
+        static_cast<int32_t>(localIndex / (SECTOR_SIZE * SECTOR_SIZE))
+      };
+
+      for (const Coords& dir : DIRECTIONS) {
+        Coords next = local + dir;
+        if (static_cast<uint32_t>(next.x) >= static_cast<uint32_t>(sector.size.x)
+            || static_cast<uint32_t>(next.y) >= static_cast<uint32_t>(sector.size.y)
+            || static_cast<uint32_t>(next.z) >= static_cast<uint32_t>(sector.size.z)) {
+          continue;
+        }
+
+        Coords pos = sector.min + next;
+        uint32_t nextIndex = GetLocalIndex(sector, pos);
+        if (scratch.sectorDistances[nextIndex] != UNREACHABLE || m_Obstacles->Test(m_Obstacles->GetIndex(pos))) { continue; }
+
+        scratch.sectorDistances[nextIndex] = distance + 1;
+        scratch.sectorFrontier.Push(nextIndex);
+      }
+    }
+  }
+
+  uint32_t SectorGraph::GetNeighborSector(uint32_t sector, uint32_t axis, int32_t offset) const noexcept {
+    Coords pos{
+      static_cast<int32_t>(sector % static_cast<uint32_t>(m_SectorCounts.x)),
+      static_cast<int32_t>(sector / static_cast<uint32_t>(m_SectorCounts.x) % static_cast<uint32_t>(m_SectorCounts.y)),
+      static_cast<int32_t>(sector / static_cast<uint32_t>(m_SectorCounts.x * m_SectorCounts.y))
+    };
+
+    int32_t& coordinate = GetAxis(pos, axis);
+    coordinate += offset;
+    if (coordinate < 0 || coordinate >= GetAxis(m_SectorCounts, axis)) { return INVALID_SECTOR; }
+
+    return static_cast<uint32_t>(pos.x + pos.y * m_SectorCounts.x + pos.z * m_SectorCounts.x * m_SectorCounts.y);
+  }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "OccupancyGrid.h"
+#include "SearchScratch.h"
+
+namespace Snake {
+  // Abstract graph over cubes of SECTOR_SIZE cells for long-range planning (HPA*).
+  // The largest open regions of a face between two sectors get a pair of portal cells, one on each side,
+  // and every sector caches the distances between its own portals. Only sectors whose cells changed
+  // since the previous update, or whose faces gained or lost portals, are rebuilt.
+  class SectorGraph {
+  public:
+    static constexpr uint16_t UNREACHABLE = std::numeric_limits<uint16_t>::max();
+    static constexpr uint32_t INVALID_SECTOR = std::numeric_limits<uint32_t>::max();
+
+    struct Route {
+      // Portal cell where the route leaves the start sector
+      uint32_t waypoint = 0;
+      uint32_t waypointDistance = 0;
+
+      // Estimated length from the start to the goal
+      uint32_t length = 0;
+    };
+
+    SectorGraph() = default;
+
+    // Diffs the grid against the previous update, refreshes the portals and collects the sectors that have to be rebuilt.
+    // The grid has to outlive the graph.
+    void Update(const OccupancyGrid& obstacles);
+
+    // Recomputes the cached portal distances of one dirty sector, different sectors can be rebuilt in parallel
+    void RebuildSector(uint32_t sector, SearchScratch& scratch);
+
+    // Plans across portals, returns nothing when both cells share a sector or the goal cannot be reached
+    std::optional<Route> FindRoute(const Coords& start, const Coords& goal, SearchScratch& scratch) const;
+
+    inline uint32_t GetSectorIndex(const Coords& pos) const noexcept {
+      return static_cast<uint32_t>(pos.x) / SECTOR_SIZE
+        + static_cast<uint32_t>(pos.y) / SECTOR_SIZE * static_cast<uint32_t>(m_SectorCounts.x)
+        + static_cast<uint32_t>(pos.z) / SECTOR_SIZE * static_cast<uint32_t>(m_SectorCounts.x * m_SectorCounts.y);
+    }
+
+    inline const std::vector<uint32_t>& GetDirtySectors() const noexcept { return m_DirtySectors; }
+    inline uint64_t GetSectorCount() const noexcept { return m_Sectors.size(); }
+    inline uint64_t GetPortalCount() const noexcept { return m_Portals.size(); }
+
+  private:
+    struct Portal {
+      Coords pos{ 0, 0, 0 };
+      uint32_t cell = 0;
+      uint32_t sector = 0;
+
+      // Portal on the other side of the face, one step away
+      uint32_t peer = 0;
+    };
+
+    struct Sector {
+      Coords min{ 0, 0, 0 };
+      Coords size{ 0, 0, 0 };
+      uint32_t firstPortal = 0;
+      uint32_t portalCount = 0;
+
+      // Row-major portalCount x portalCount matrix of distances inside the sector
+      std::vector<uint16_t> distances;
+    };
+
+    // Cell pairs across the face between a sector and its neighbor in the positive direction of one axis
+    struct Face {
+      std::vector<std::pair<uint32_t, uint32_t>> portals;
+      uint32_t firstNearPortal = 0;
+      uint32_t firstFarPortal = 0;
+    };
+
+    void Reset(const OccupancyGrid& obstacles);
+    bool RebuildFace(uint32_t sector, uint32_t axis);
+    void AssignPortals();
+
+    // Sector-local BFS from the position over the obstacles, results are indexed by GetLocalIndex
+    void ComputeSectorDistances(const Sector& sector, const Coords& from, SearchScratch& scratch) const;
+
+    inline uint32_t GetLocalIndex(const Sector& sector, const Coords& pos) const noexcept {
+      return static_cast<uint32_t>(pos.x - sector.min.x)
+        + static_cast<uint32_t>(pos.y - sector.min.y) * SECTOR_SIZE
+        + static_cast<uint32_t>(pos.z - sector.min.z) * SECTOR_SIZE * SECTOR_SIZE;
+    }
+
+    inline uint32_t GetFaceIndex(uint32_t sector, uint32_t axis) const noexcept { return sector * 3 + axis; }
+
+    // Neighboring sector along an axis, the offset is +1 or -1
+    uint32_t GetNeighborSector(uint32_t sector, uint32_t axis, int32_t offset) const noexcept;
+
+  private:
+    const OccupancyGrid* m_Obstacles = nullptr;
+
+    Coords m_Extent{ 0, 0, 0 };
+    Coords m_SectorCounts{ 0, 0, 0 };
+    std::vector<uint64_t> m_Snapshot;
+
+    std::vector<Sector> m_Sectors;
+    std::vector<Face> m_Faces;
+    std::vector<Portal> m_Portals;
+
+    std::vector<uint8_t> m_IsDirty;
+    std::vector<uint32_t> m_DirtySectors;
+
+    // Flood fill buffers for the open regions of one face
+    std::vector<uint8_t> m_FaceCells;
+    std::vector<uint32_t> m_FaceStack;
+    std::vector<uint32_t> m_FaceRegion;
+    std::vector<std::pair<uint32_t, uint32_t>> m_FaceRegions;
+  };
+}
@@ -0,0 +1,262 @@
+#include "Simulator.h"
+
+#include <cstring>
+
+namespace Snake {
+  // Smallest ring buffer per snake, bodies longer than their ring stop growing
+  constexpr uint32_t MIN_RING_CAPACITY = 256;
+
+  void SimState::CopyFrom(const SimState& other) {
+    m_Header = other.m_Header;
+    if (m_Data.size() != other.m_Data.size()) {
+      m_Data.resize(other.m_Data.size());
+    }
+
+    std::memcpy(m_Data.data(), other.m_Data.data(), other.m_Data.size() * sizeof(uint32_t));
+    m_DirtyWords.clear();
+  }
+
+  void SimState::RestoreFrom(const SimState& base) {
+    // Only the snakes in use are copied, the rest of the header is never read
+    m_Header.snakeCount = base.m_Header.snakeCount;
+    m_Header.turn = base.m_Header.turn;
+    std::copy_n(base.m_Header.snakes.begin(), base.m_Header.snakeCount, m_Header.snakes.begin());
+
+    for (uint32_t word : m_DirtyWords) {
+      m_Data[word] = base.m_Data[word];
+    }
+    m_DirtyWords.clear();
+  }
+
+  void Simulator::Load(const GameState& gameState, uint32_t tickDurationMs) {
+    if (gameState.name != m_RoundName || gameState.mapSize != m_Fences.GetExtent() || gameState.fences.size() != m_FenceCount
+        || m_Fences.GetCellCount() == 0) {
+      m_RoundName = gameState.name;
+      m_FenceCount = gameState.fences.size();
+      m_Fences.Resize(gameState.mapSize);
+      for (const Coords& fence : gameState.fences) {
+        m_Fences.Set(fence);
+      }
+    }
+
+    m_Food.Build(gameState.food, gameState.specialFood);
+
+    uint32_t tickMs = std::max<uint32_t>(tickDurationMs, 1);
+    m_ReviveTicks = (gameState.reviveTimeoutSec * 1000 + tickMs - 1) / tickMs;
+
+    uint64_t longestBody = 0;
+    for (const PlayerSnake& snake : gameState.snakes) {
+      longestBody = std::max<uint64_t>(longestBody, snake.geometry.size());
+    }
+
+    for (const EnemySnake& enemy : gameState.enemies) {
+      longestBody = std::max<uint64_t>(longestBody, enemy.geometry.size());
+    }
+
+    m_RingCapacity = static_cast<uint32_t>(std::bit_ceil(std::max<uint64_t>(longestBody * 2, MIN_RING_CAPACITY)));
+
+    uint64_t snakeCount = std::min<uint64_t>(gameState.snakes.size() + gameState.enemies.size(), SimState::MAX_SNAKES);
+    uint32_t cellWords = (m_Fences.GetCellCount() + 31) / 32;
+
+    SimState& state = m_InitialState;
+    state.m_Header = SimState::Header{};
+    state.m_Header.turn = gameState.turn;
+    state.m_Header.foodOffset = cellWords;
+    state.m_Header.ringMask = m_RingCapacity - 1;
+    state.m_Data.assign(static_cast<uint64_t>(cellWords) * 2 + snakeCount * m_RingCapacity, 0);
+
+    for (const FoodIndex::Entry& food : m_Food.GetEntries()) {
+      if (!m_Fences.IsBlocked(food.coords)) {
+        state.SetBit(state.m_Header.foodOffset, m_Fences.GetIndex(food.coords));
+      }
+    }
+
+    // Our snakes come first, so snake indices match GameState::snakes
+    for (const PlayerSnake& snake : gameState.snakes) {
+      AddSnake(snake.geometry, snake.direction, snake.status == SnakeStatus::Alive, (snake.reviveRemainMs + tickMs - 1) / tickMs, true);
+    }
+
+    for (const EnemySnake& enemy : gameState.enemies) {
+      AddSnake(enemy.geometry, Coords{ 0, 0, 0 }, enemy.status == SnakeStatus::Alive, m_ReviveTicks, false);
+    }
+
+    // The initial state is the base others are restored to, its own writes are not undone
+    state.m_DirtyWords.clear();
+  }
+
+  void Simulator::Step(SimState& state, const uint8_t* moves) const {
+    SimState::Header& header = state.m_Header;
+    std::array<Coords, SimState::MAX_SNAKES> targets;
+    std::array<uint32_t, SimState::MAX_SNAKES> targetIndices;
+    std::array<bool, SimState::MAX_SNAKES> eats;
+
+    // A snake cannot turn back into its own neck
+    for (uint32_t i = 0; i < header.snakeCount; ++i) {
+      SimState::SnakeState& snake = header.snakes[i];
+      targetIndices[i] = OccupancyGrid::INVALID_INDEX;
+      eats[i] = false;
+      if (!snake.isAlive) { continue; }
+
+      uint8_t move = moves[i];
+      if (move < DIRECTIONS.size() && (snake.length < 2 || move != GetOppositeDirection(snake.direction))) {
+        snake.direction = move;
+      }
+
+      targets[i] = snake.head + DIRECTIONS[snake.direction];
+      if (m_Fences.IsBlocked(targets[i])) { continue; }
+
+      targetIndices[i] = m_Fences.GetIndex(targets[i]);
+      eats[i] = state.HasFood(targetIndices[i]);
+    }
+
+    // Tails leave before the heads arrive
+    for (uint32_t i = 0; i < header.snakeCount; ++i) {
+      SimState::SnakeState& snake = header.snakes[i];
+      if (!snake.isAlive || (eats[i] && snake.length < m_RingCapacity)) { continue; }
+
+      state.ResetBit(0, state.GetSegment(snake, snake.length - 1));
+      --snake.length;
+    }
+
+    std::array<bool, SimState::MAX_SNAKES> dies;
+    for (uint32_t i = 0; i < header.snakeCount; ++i) {
+      dies[i] = header.snakes[i].isAlive && (targetIndices[i] == OccupancyGrid::INVALID_INDEX || state.IsOccupied(targetIndices[i]));
+    }
+
+    // Heads meeting in one cell take each other out
+    for (uint32_t i = 0; i < header.snakeCount; ++i) {
+      if (targetIndices[i] == OccupancyGrid::INVALID_INDEX) { continue; }
+
+      for (uint32_t j = i + 1; j < header.snakeCount; ++j) {
+        if (targetIndices[j] == targetIndices[i]) {
+          dies[i] = true;
+          dies[j] = true;
+        }
+      }
+    }
+
+    for (uint32_t i = 0; i < header.snakeCount; ++i) {
+      SimState::SnakeState& snake = header.snakes[i];
+      if (!snake.isAlive) { continue; }
+
+      if (dies[i]) {
+        Kill(state, snake);
+        continue;
+      }
+
+      uint32_t index = targetIndices[i];
+      snake.headSlot = (snake.headSlot + 1) & header.ringMask;
+      state.SetWord(snake.ringOffset + snake.headSlot, index);
+      state.SetBit(0, index);
+      snake.head = targets[i];
+      ++snake.length;
+
+      if (eats[i]) {
+        state.ResetBit(header.foodOffset, index);
+        if (const FoodIndex::Entry* food = m_Food.Find(targets[i])) {
+          snake.score += food->points;
+        }
+      }
+    }
+
+    // Revived snakes only see the bodies after every head has moved. Snakes that died this tick start their timer.
+    for (uint32_t i = 0; i < header.snakeCount; ++i) {
+      SimState::SnakeState& snake = header.snakes[i];
+      if (!snake.isAlive && !dies[i]) {
+        Revive(state, snake);
+      }
+    }
+
+    ++header.turn;
+  }
+
+  bool Simulator::IsMoveSafe(const SimState& state, uint32_t snakeIndex, uint8_t move) const noexcept {
+    const SimState::SnakeState& snake = state.GetSnake(snakeIndex);
+    if (!snake.isAlive || move >= DIRECTIONS.size() || (snake.length > 1 && move == GetOppositeDirection(snake.direction))) { return false; }
+
+    Coords target = snake.head + DIRECTIONS[move];
+    if (m_Fences.IsBlocked(target)) { return false; }
+
+    // The own tail moves out of the way unless the head lands on food
+    uint32_t index = m_Fences.GetIndex(target);
+    return !state.IsOccupied(index) || (index == state.GetSegment(snake, snake.length - 1) && !state.HasFood(index));
+  }
+
+  void Simulator::AddSnake(const std::vector<Coords>& geometry, const Coords& direction, bool isAlive, uint32_t reviveTicks,
+                           bool isPlayer) {
+    SimState& state = m_InitialState;
+    SimState::Header& header = state.m_Header;
+    if (header.snakeCount == SimState::MAX_SNAKES) { return; }
+
+    SimState::SnakeState& snake = header.snakes[header.snakeCount];
+    snake.ringOffset = header.foodOffset * 2 + header.snakeCount * m_RingCapacity;
+    snake.isPlayer = isPlayer;
+    ++header.snakeCount;
+
+    if (!geometry.empty() && m_Fences.IsInside(geometry.front())) {
+      snake.spawnIndex = m_Fences.GetIndex(geometry.front());
+    }
+
+    if (!isAlive || snake.spawnIndex == OccupancyGrid::INVALID_INDEX) {
+      snake.reviveTicks = reviveTicks;
+      return;
+    }
+
+    // Enemies report no direction, their neck tells where they came from
+    snake.direction = GetDirectionIndex(direction);
+    if (direction == Coords{ 0, 0, 0 } && geometry.size() > 1) {
+      snake.direction = GetDirectionIndex(geometry[0] - geometry[1]);
+    }
+
+    // Segments past the first one outside of the map are dropped
+    uint32_t length = 0;
+    while (length < std::min<uint64_t>(geometry.size(), m_RingCapacity) && m_Fences.IsInside(geometry[length])) { ++length; }
+
+    // Slot zero holds the tail, the head ends up in the highest slot
+    for (uint32_t slot = 0; slot < length; ++slot) {
+      uint32_t index = m_Fences.GetIndex(geometry[length - 1 - slot]);
+      state.SetWord(snake.ringOffset + slot, index);
+      state.SetBit(0, index);
+    }
+
+    snake.head = geometry.front();
+    snake.headSlot = length - 1;
+    snake.length = length;
+    snake.isAlive = true;
+  }
+
+  void Simulator::Kill(SimState& state, SimState::SnakeState& snake) const {
+    for (uint32_t k = 0; k < snake.length; ++k) {
+      state.ResetBit(0, state.GetSegment(snake, k));
+    }
+
+    snake.length = 0;
+    snake.isAlive = false;
+    snake.reviveTicks = m_ReviveTicks;
+  }
+
+  void Simulator::Revive(SimState& state, SimState::SnakeState& snake) const {
+    if (snake.reviveTicks > 0) {
+      --snake.reviveTicks;
+      return;
+    }
+
+    // A spawn cell taken by another body delays the revive by a tick
+    if (snake.spawnIndex == OccupancyGrid::INVALID_INDEX || state.IsOccupied(snake.spawnIndex)) { return; }
+
+    snake.headSlot = (snake.headSlot + 1) & state.m_Header.ringMask;
+    state.SetWord(snake.ringOffset + snake.headSlot, snake.spawnIndex);
+    state.SetBit(0, snake.spawnIndex);
+    snake.head = m_Fences.GetCoords(snake.spawnIndex);
+    snake.length = 1;
+    snake.isAlive = true;
+  }
+
+  uint8_t Simulator::GetDirectionIndex(const Coords& direction) noexcept {
+    for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+      if (DIRECTIONS[i] == direction) { return i; }
+    }
+
+    return 0;
+  }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "OccupancyGrid.h"
+#include "FoodIndex.h"
+
+namespace Snake {
+  // Mutable part of a simulated game. A fixed header describes the snakes, and one flat buffer holds the bit-packed
+  // bodies, the bit-packed food and every snake body as a ring buffer of cell indices. Copying a state into another
+  // state of the same round is a memcpy of both and never allocates.
+  // Every word written to the buffer is logged, so a copy that was stepped a few ticks goes back to its source by
+  // restoring only those words instead of copying the whole map again.
+  class SimState {
+  public:
+    static constexpr uint32_t MAX_SNAKES = 64;
+
+    struct SnakeState {
+      Coords head{ 0, 0, 0 };
+      int32_t score = 0;
+
+      // Slot of the head in the ring buffer, older segments sit at lower slots
+      uint32_t headSlot = 0;
+      uint32_t length = 0;
+      uint32_t ringOffset = 0;
+
+      uint32_t spawnIndex = OccupancyGrid::INVALID_INDEX;
+      uint32_t reviveTicks = 0;
+      uint8_t direction = 0;
+      bool isAlive = false;
+      bool isPlayer = false;
+    };
+
+    SimState() = default;
+
+    void CopyFrom(const SimState& other);
+
+    // Undoes every write since the last CopyFrom or RestoreFrom, which has to have been from the same base
+    void RestoreFrom(const SimState& base);
+
+    inline uint32_t GetSnakeCount() const noexcept { return m_Header.snakeCount; }
+    inline const SnakeState& GetSnake(uint32_t index) const noexcept { return m_Header.snakes[index]; }
+    inline uint32_t GetTurn() const noexcept { return m_Header.turn; }
+
+    inline bool IsOccupied(uint32_t index) const noexcept { return TestBit(0, index); }
+    inline bool HasFood(uint32_t index) const noexcept { return TestBit(m_Header.foodOffset, index); }
+
+    // Body cell k segments behind the head
+    inline uint32_t GetSegment(const SnakeState& snake, uint32_t k) const noexcept {
+      return m_Data[snake.ringOffset + ((snake.headSlot - k) & m_Header.ringMask)];
+    }
+
+  private:
+    friend class Simulator;
+
+    struct Header {
+      std::array<SnakeState, MAX_SNAKES> snakes{};
+      uint32_t snakeCount = 0;
+      uint32_t turn = 0;
+      uint32_t foodOffset = 0;
+      uint32_t ringMask = 0;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header>);
+
+    inline bool TestBit(uint32_t offset, uint32_t index) const noexcept { return (m_Data[offset + (index >> 5)] >> (index & 31)) & 1; }
+
+    inline void SetBit(uint32_t offset, uint32_t index) {
+      uint32_t word = offset + (index >> 5);
+      m_DirtyWords.push_back(word);
+      m_Data[word] |= 1u << (index & 31);
+    }
+
+    inline void ResetBit(uint32_t offset, uint32_t index) {
+      uint32_t word = offset + (index >> 5);
+      m_DirtyWords.push_back(word);
+      m_Data[word] &= ~(1u << (index & 31));
+    }
+
+    inline void SetWord(uint32_t word, uint32_t value) {
+      m_DirtyWords.push_back(word);
+      m_Data[word] = value;
+    }
+
+  private:
+    Header m_Header;
+    std::vector<uint32_t> m_Data;
+
+    // Words written since the last copy or restore, a word written twice shows up twice
+    std::vector<uint32_t> m_DirtyWords;
+  };
+
+  // Forward model of the game rules over SimState, loaded once from a GameState.
+  // Every tick all alive snakes move at once. A snake that lands on food grows by one segment and scores its points,
+  // every other snake drops its tail before heads are checked, so a head may follow a tail into its cell. Heads that leave
+  // the map, hit a fence or a body, or meet another head in the same cell die and lose their body. Dead snakes come back
+  // with a single segment where their head was loaded once their revive timer runs out and the cell is free, snakes that
+  // were loaded dead have no such cell and stay dead.
+  class Simulator {
+  public:
+    static constexpr uint8_t NO_MOVE = std::numeric_limits<uint8_t>::max();
+
+    Simulator() = default;
+
+    // Fences and food points are kept by the simulator, snakes and food presence go into the initial state.
+    // Revive timers are converted from milliseconds with the given tick duration.
+    void Load(const GameState& gameState, uint32_t tickDurationMs);
+
+    inline const SimState& GetInitialState() const noexcept { return m_InitialState; }
+
+    // Applies one move per snake, indexed like the snakes of the state. NO_MOVE and reversals keep the current direction.
+    void Step(SimState& state, const uint8_t* moves) const;
+
+    // True when the move leaves the head on a free, in-map cell, ignoring what the other snakes do this tick
+    bool IsMoveSafe(const SimState& state, uint32_t snakeIndex, uint8_t move) const noexcept;
+
+    inline const OccupancyGrid& GetFences() const noexcept { return m_Fences; }
+
+  private:
+    void AddSnake(const std::vector<Coords>& geometry, const Coords& direction, bool isAlive, uint32_t reviveTicks, bool isPlayer);
+
+    void Kill(SimState& state, SimState::SnakeState& snake) const;
+    void Revive(SimState& state, SimState::SnakeState& snake) const;
+
+    static uint8_t GetDirectionIndex(const Coords& direction) noexcept;
+
+  private:
+    // Fences only change with the round, like in WorldModel the round is told apart by its name, map size and fence count
+    std::string m_RoundName;
+    uint64_t m_FenceCount = 0;
+    OccupancyGrid m_Fences;
+    FoodIndex m_Food;
+    uint32_t m_ReviveTicks = 0;
+    uint32_t m_RingCapacity = 0;
+
+    SimState m_InitialState;
+  };
+}
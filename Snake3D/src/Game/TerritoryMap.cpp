@@ -0,0 +1,58 @@
+#include "TerritoryMap.h"
+
+namespace Snake {
+  void TerritoryMap::Build(const OccupancyGrid& obstacles, const std::vector<PlayerSnake>& snakes, const std::vector<EnemySnake>& enemies) {
+    m_Obstacles = &obstacles;
+
+    uint32_t cellCount = obstacles.GetCellCount();
+    m_Owners.assign(cellCount, NO_OWNER);
+    m_Distances.assign(cellCount, UNREACHABLE);
+    m_Frontier.Prepare(obstacles);
+
+    for (uint64_t i = 0; i < std::min<uint64_t>(snakes.size(), MAX_PLAYER_SNAKES); ++i) {
+      if (snakes[i].status != SnakeStatus::Alive || snakes[i].geometry.empty()) { continue; }
+
+      AddHead(snakes[i].geometry.front(), static_cast<uint8_t>(i));
+    }
+
+    for (const EnemySnake& enemy : enemies) {
+      if (enemy.status != SnakeStatus::Alive || enemy.geometry.empty()) { continue; }
+
+      AddHead(enemy.geometry.front(), ENEMY);
+    }
+
+    while (m_Frontier.GetDepth() + 2 < UNREACHABLE && m_Frontier.Expand()) {
+      uint16_t distance = static_cast<uint16_t>(m_Frontier.GetDepth() + 1);
+
+      // A cell can be entered from several cells of the previous layer, every one of their owners gets there first
+      m_Frontier.ForEachFrontierCell([this, &obstacles, distance](uint32_t index, uint8_t) {
+        Coords pos = obstacles.GetCoords(index);
+        uint8_t owner = NO_OWNER;
+        for (uint8_t i = 0; i < DIRECTIONS.size(); ++i) {
+          Coords newPos = pos + DIRECTIONS[i];
+          if (!obstacles.IsInside(newPos)) { continue; }
+
+          uint32_t newIndex = obstacles.GetNeighborIndex(index, i);
+          if (m_Distances[newIndex] == distance - 1) {
+            owner = MergeOwners(owner, m_Owners[newIndex]);
+          }
+        }
+
+        m_Owners[index] = owner;
+        m_Distances[index] = distance;
+      });
+    }
+  }
+
+  void TerritoryMap::AddHead(const Coords& head, uint8_t owner) {
+    for (const Coords& dir : DIRECTIONS) {
+      Coords pos = head + dir;
+      if (m_Obstacles->IsBlocked(pos)) { continue; }
+
+      uint32_t index = m_Obstacles->GetIndex(pos);
+      m_Owners[index] = MergeOwners(m_Owners[index], owner);
+      m_Distances[index] = 1;
+      m_Frontier.Seed(index);
+    }
+  }
+}
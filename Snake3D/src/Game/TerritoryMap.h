@@ -0,0 +1,55 @@
+#pragma once
+
+#include "OccupancyGrid.h"
+#include "BitFrontier.h"
+
+namespace Snake {
+  // Voronoi partition of the free cells between all alive heads, from one bit-parallel multi-source BFS per tick.
+  // Every reached cell stores the snake that gets there first and its distance. Our snakes are told apart by their
+  // index in GameState::snakes, enemies share one owner. Cells an enemy reaches as early as one of our snakes are
+  // contested, ties between our own snakes go to the lower index.
+  class TerritoryMap {
+  public:
+    static constexpr uint8_t NO_OWNER = std::numeric_limits<uint8_t>::max();
+    static constexpr uint8_t CONTESTED = NO_OWNER - 1;
+    static constexpr uint8_t ENEMY = NO_OWNER - 2;
+    static constexpr uint32_t MAX_PLAYER_SNAKES = ENEMY;
+
+    static constexpr uint16_t UNREACHABLE = std::numeric_limits<uint16_t>::max();
+
+    TerritoryMap() = default;
+
+    // Heads are part of the snake bodies, so the search starts from their free neighbors at distance one
+    void Build(const OccupancyGrid& obstacles, const std::vector<PlayerSnake>& snakes, const std::vector<EnemySnake>& enemies);
+
+    inline uint8_t GetOwner(uint32_t index) const noexcept { return m_Owners[index]; }
+    inline uint16_t GetDistance(uint32_t index) const noexcept { return m_Distances[index]; }
+
+    // False when an enemy or another of our snakes gets to the cell strictly first
+    inline bool CanWin(const Coords& pos, uint32_t snakeIndex) const noexcept {
+      if (m_Obstacles == nullptr || !m_Obstacles->IsInside(pos)) { return false; }
+
+      uint8_t owner = m_Owners[m_Obstacles->GetIndex(pos)];
+      return owner == snakeIndex || owner == CONTESTED || owner == NO_OWNER;
+    }
+
+  private:
+    void AddHead(const Coords& head, uint8_t owner);
+
+    // Owner of a cell reached from cells with both owners in the same layer
+    static inline uint8_t MergeOwners(uint8_t lhs, uint8_t rhs) noexcept {
+      if (lhs == NO_OWNER || lhs == rhs) { return rhs; }
+      if (rhs == NO_OWNER) { return lhs; }
+      if (lhs == CONTESTED || rhs == CONTESTED || lhs == ENEMY || rhs == ENEMY) { return CONTESTED; }
+
+      return std::min(lhs, rhs);
+    }
+
+  private:
+    const OccupancyGrid* m_Obstacles = nullptr;
+
+    std::vector<uint8_t> m_Owners;
+    std::vector<uint16_t> m_Distances;
+    BitFrontier m_Frontier;
+  };
+}
@@ -0,0 +1,214 @@
+#include "WorldModel.h"
+
+namespace Snake {
+  // A snake that eats keeps its tail for one more tick
+  constexpr uint32_t GROWTH_CLEARANCE_MARGIN = 1;
+
+  void WorldModel::Update(const GameState& gameState) {
+    m_ChangedCells.clear();
+    m_WasRebuilt = false;
+
+    if (!IsSameRound(gameState)) {
+      Rebuild(gameState);
+      UpdateClearance(gameState);
+      return;
+    }
+
+    // Our snakes are matched by id, anything left unmatched has disappeared
+    m_NextSnakes.resize(gameState.snakes.size());
+    for (uint64_t i = 0; i < gameState.snakes.size(); ++i) {
+      const PlayerSnake& snake = gameState.snakes[i];
+      const std::vector<Coords>& current = GetAliveGeometry(snake.status, snake.geometry);
+
+      auto it = std::find_if(m_Snakes.begin(), m_Snakes.end(), [&snake](const TrackedSnake& tracked) {
+        return tracked.key == snake.key;
+      });
+
+      if (it != m_Snakes.end()) {
+        UpdateSnake(it->geometry, current);
+        it->key = TrackedSnake::NO_KEY;
+      } else {
+        AddSnake(current);
+      }
+
+      m_NextSnakes[i].key = snake.key;
+      m_NextSnakes[i].geometry.assign(current.begin(), current.end());
+    }
+
+    for (const TrackedSnake& tracked : m_Snakes) {
+      if (tracked.key != TrackedSnake::NO_KEY) {
+        RemoveSnake(tracked.geometry);
+      }
+    }
+
+    std::swap(m_Snakes, m_NextSnakes);
+
+    // Enemies have no id and are matched by their position in the list
+    for (uint64_t i = 0; i < gameState.enemies.size(); ++i) {
+      const EnemySnake& enemy = gameState.enemies[i];
+      const std::vector<Coords>& current = GetAliveGeometry(enemy.status, enemy.geometry);
+
+      if (i < m_Enemies.size()) {
+        UpdateSnake(m_Enemies[i], current);
+      } else {
+        AddSnake(current);
+      }
+    }
+
+    for (uint64_t i = gameState.enemies.size(); i < m_Enemies.size(); ++i) {
+      RemoveSnake(m_Enemies[i]);
+    }
+
+    m_Enemies.resize(gameState.enemies.size());
+    for (uint64_t i = 0; i < gameState.enemies.size(); ++i) {
+      const EnemySnake& enemy = gameState.enemies[i];
+      const std::vector<Coords>& current = GetAliveGeometry(enemy.status, enemy.geometry);
+      m_Enemies[i].assign(current.begin(), current.end());
+    }
+
+    UpdateClearance(gameState);
+  }
+
+  bool WorldModel::IsSameRound(const GameState& gameState) const noexcept {
+    return m_StaticLayer.GetCellCount() != 0
+      && gameState.mapSize == m_MapSize
+      && gameState.fences.size() == m_FenceCount
+      && gameState.name == m_RoundName;
+  }
+
+  void WorldModel::Rebuild(const GameState& gameState) {
+    m_RoundName = gameState.name;
+    m_MapSize = gameState.mapSize;
+    m_FenceCount = gameState.fences.size();
+
+    if (m_StaticLayer.GetExtent() == gameState.mapSize) {
+      m_StaticLayer.Clear();
+    } else {
+      m_StaticLayer.Resize(gameState.mapSize);
+    }
+
+    for (const Coords& fence : gameState.fences) {
+      m_StaticLayer.Set(fence);
+    }
+
+    m_Obstacles = m_StaticLayer;
+    m_DynamicCounts.assign(m_StaticLayer.GetCellCount(), 0);
+    m_Clearance.Resize(m_StaticLayer.GetCellCount());
+
+    // Fences are counted here, snake cells follow through AddDynamic
+    if (m_Bricks.GetExtent() != gameState.mapSize) {
+      m_Bricks.Resize(gameState.mapSize);
+    }
+    m_Bricks.Build(m_StaticLayer);
+
+    m_Snakes.resize(gameState.snakes.size());
+    for (uint64_t i = 0; i < gameState.snakes.size(); ++i) {
+      const PlayerSnake& snake = gameState.snakes[i];
+      const std::vector<Coords>& geometry = GetAliveGeometry(snake.status, snake.geometry);
+      AddSnake(geometry);
+
+      m_Snakes[i].key = snake.key;
+      m_Snakes[i].geometry.assign(geometry.begin(), geometry.end());
+    }
+
+    m_Enemies.resize(gameState.enemies.size());
+    for (uint64_t i = 0; i < gameState.enemies.size(); ++i) {
+      const EnemySnake& enemy = gameState.enemies[i];
+      const std::vector<Coords>& geometry = GetAliveGeometry(enemy.status, enemy.geometry);
+      AddSnake(geometry);
+
+      m_Enemies[i].assign(geometry.begin(), geometry.end());
+    }
+
+    m_ChangedCells.clear();
+    m_WasRebuilt = true;
+  }
+
+  void WorldModel::UpdateClearance(const GameState& gameState) {
+    m_Clearance.Reset();
+
+    for (const PlayerSnake& snake : gameState.snakes) {
+      MarkBody(GetAliveGeometry(snake.status, snake.geometry));
+    }
+
+    for (const EnemySnake& enemy : gameState.enemies) {
+      MarkBody(GetAliveGeometry(enemy.status, enemy.geometry));
+    }
+  }
+
+  void WorldModel::MarkBody(const std::vector<Coords>& geometry) {
+    uint64_t length = geometry.size();
+    for (uint64_t i = 0; i < length; ++i) {
+      if (!m_StaticLayer.IsInside(geometry[i])) { continue; }
+
+      uint32_t index = m_StaticLayer.GetIndex(geometry[i]);
+      if (m_StaticLayer.Test(index)) { continue; }
+
+      uint64_t clearTick = std::min<uint64_t>(length - i + GROWTH_CLEARANCE_MARGIN, ClearanceMap::NEVER - 1);
+      m_Clearance.Mark(index, static_cast<uint8_t>(clearTick));
+    }
+  }
+
+  void WorldModel::UpdateSnake(const std::vector<Coords>& previous, const std::vector<Coords>& current) {
+    // A snake that moved one step gained a new head and lost at most its old tail, the rest stays in place
+    if (previous.size() >= 2 && current.size() >= 2 && current.size() <= previous.size() + 1
+        && current[1] == previous[0] && current.back() == previous[current.size() - 2]) {
+      // Additions go first so cells that stay occupied never flicker
+      AddDynamic(current.front());
+
+      for (uint64_t i = current.size() - 1; i < previous.size(); ++i) {
+        RemoveDynamic(previous[i]);
+      }
+      return;
+    }
+
+    if (previous == current) { return; }
+
+    AddSnake(current);
+    RemoveSnake(previous);
+  }
+
+  void WorldModel::AddSnake(const std::vector<Coords>& geometry) {
+    for (const Coords& pos : geometry) {
+      AddDynamic(pos);
+    }
+  }
+
+  void WorldModel::RemoveSnake(const std::vector<Coords>& geometry) {
+    for (const Coords& pos : geometry) {
+      RemoveDynamic(pos);
+    }
+  }
+
+  void WorldModel::AddDynamic(const Coords& pos) {
+    if (!m_StaticLayer.IsInside(pos)) { return; }
+
+    uint32_t index = m_StaticLayer.GetIndex(pos);
+    if (m_DynamicCounts[index]++ == 0 && !m_StaticLayer.Test(index)) {
+      m_Obstacles.Set(index);
+      m_Bricks.AddBlocked(pos);
+      m_ChangedCells.push_back(index);
+    }
+  }
+
+  void WorldModel::RemoveDynamic(const Coords& pos) {
+    if (!m_StaticLayer.IsInside(pos)) { return; }
+
+    uint32_t index = m_StaticLayer.GetIndex(pos);
+    if (m_DynamicCounts[index] == 0) {
+      CORE_ERROR("Failed to remove dynamic obstacle: cell ({}, {}, {}) is not occupied!", pos.x, pos.y, pos.z);
+      return;
+    }
+
+    if (--m_DynamicCounts[index] == 0 && !m_StaticLayer.Test(index)) {
+      m_Obstacles.Reset(index);
+      m_Bricks.RemoveBlocked(pos);
+      m_ChangedCells.push_back(index);
+    }
+  }
+
+  const std::vector<Coords>& WorldModel::GetAliveGeometry(SnakeStatus status, const std::vector<Coords>& geometry) noexcept {
+    static const std::vector<Coords> EMPTY_GEOMETRY;
+    return status == SnakeStatus::Alive ? geometry : EMPTY_GEOMETRY;
+  }
+}
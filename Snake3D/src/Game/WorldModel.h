@@ -0,0 +1,76 @@
+#pragma once
+
+#include "OccupancyGrid.h"
+#include "ClearanceMap.h"
+#include "BrickGrid.h"
+
+namespace Snake {
+  // Persistent obstacle model of the current round.
+  // The static layer holds fences and is only rebuilt when the round changes. The dynamic layer holds
+  // snake bodies as per-cell reference counts and is updated from the
+  // difference between consecutive game states, so a tick only touches the cells that moved.
+  class WorldModel {
+  public:
+    WorldModel() = default;
+
+    void Update(const GameState& gameState);
+
+    inline const OccupancyGrid& GetStaticLayer() const noexcept { return m_StaticLayer; }
+
+    // Union of the static and dynamic layers
+    inline const OccupancyGrid& GetObstacles() const noexcept { return m_Obstacles; }
+
+    // Blocked cell counts per brick of the obstacles, for searches that step over open space
+    inline const BrickGrid& GetBricks() const noexcept { return m_Bricks; }
+
+    // Ticks after which each dynamic obstacle clears, rebuilt from the snake bodies every update
+    inline const ClearanceMap& GetClearance() const noexcept { return m_Clearance; }
+
+    // Cells whose combined occupancy changed during the last update.
+    // Not filled when the whole model was rebuilt, check WasRebuilt() first.
+    inline const std::vector<uint32_t>& GetChangedCells() const noexcept { return m_ChangedCells; }
+    inline bool WasRebuilt() const noexcept { return m_WasRebuilt; }
+
+  private:
+    struct TrackedSnake {
+      static constexpr uint32_t NO_KEY = std::numeric_limits<uint32_t>::max();
+
+      uint32_t key = NO_KEY;
+      std::vector<Coords> geometry;
+    };
+
+    bool IsSameRound(const GameState& gameState) const noexcept;
+    void Rebuild(const GameState& gameState);
+
+    void UpdateClearance(const GameState& gameState);
+    void MarkBody(const std::vector<Coords>& geometry);
+
+    void UpdateSnake(const std::vector<Coords>& previous, const std::vector<Coords>& current);
+
+    void AddSnake(const std::vector<Coords>& geometry);
+    void RemoveSnake(const std::vector<Coords>& geometry);
+
+    void AddDynamic(const Coords& pos);
+    void RemoveDynamic(const Coords& pos);
+
+    static const std::vector<Coords>& GetAliveGeometry(SnakeStatus status, const std::vector<Coords>& geometry) noexcept;
+
+  private:
+    std::string m_RoundName;
+    Coords m_MapSize{ 0, 0, 0 };
+    uint64_t m_FenceCount = 0;
+
+    OccupancyGrid m_StaticLayer;
+    std::vector<uint8_t> m_DynamicCounts;
+    OccupancyGrid m_Obstacles;
+    BrickGrid m_Bricks;
+    ClearanceMap m_Clearance;
+
+    std::vector<TrackedSnake> m_Snakes;
+    std::vector<TrackedSnake> m_NextSnakes;
+    std::vector<std::vector<Coords>> m_Enemies;
+
+    std::vector<uint32_t> m_ChangedCells;
+    bool m_WasRebuilt = false;
+  };
+}
@@ -0,0 +1,463 @@
+#include "WorldSnapshot.h"
+
+#include <charconv>
+
+// Keys of the state are short, longer ones are unknown and skipped
+constexpr uint64_t MAX_KEY_LENGTH = 32;
+
+namespace Snake {
+  // Reads the fixed layout of a server state into a snapshot. Keys it does not know are skipped,
+  // the values it knows are written straight into the snapshot arrays without an intermediate object.
+  // With a ReadMore callback the json may still be arriving, the reader waits whenever it runs out of bytes.
+  // Views into the json are only used before the next read, a wait for more bytes may move the buffer.
+  class SnapshotReader {
+  public:
+    SnapshotReader(std::string_view json, WorldSnapshot& snapshot, const WorldSnapshot::ReadMore* readMore = nullptr) noexcept
+      : m_Json(json), m_Snapshot(snapshot), m_ReadMore(readMore) {}
+
+    bool ReadState() {
+      bool isRead = ReadObject([this](std::string_view key) {
+        WorldSnapshot& snapshot = m_Snapshot;
+        if (key == "mapSize") {
+          Coords mapSize;
+          if (!ReadCoords(mapSize)) { return false; }
+
+          snapshot.SetMapSize(mapSize);
+          return true;
+        }
+
+        if (key == "name") {
+          std::string_view name;
+          if (!ReadString(name)) { return false; }
+
+          snapshot.m_Name.assign(name);
+          return true;
+        }
+
+        if (key == "points") { return ReadNumber(snapshot.m_Points); }
+        if (key == "turn") { return ReadNumber(snapshot.m_Turn); }
+        if (key == "tickRemainMs") { return ReadNumber(snapshot.m_TickRemainMs); }
+        if (key == "reviveTimeoutSec") { return ReadNumber(snapshot.m_ReviveTimeoutSec); }
+
+        if (key == "errors") {
+          return ReadArray([this, &snapshot]() {
+            std::string_view error;
+            if (!ReadString(error)) { return false; }
+
+            snapshot.m_Errors.emplace_back(error);
+            return true;
+          });
+        }
+
+        if (key == "fences") {
+          BeginSection(WorldSnapshot::Section::Fences);
+          return ReadCells(WorldSnapshot::Section::Fences);
+        }
+
+        if (key == "snakes") { return ReadSnakes(); }
+        if (key == "enemies") { return ReadEnemies(); }
+        if (key == "food") { return ReadFood(); }
+
+        if (key == "specialFood") {
+          // Every section starts where its own array is read, a kind that never shows up stays an empty range
+          return ReadObject([this](std::string_view specialKey) {
+            if (specialKey == "golden") {
+              BeginSection(WorldSnapshot::Section::Golden);
+              return ReadCells(WorldSnapshot::Section::Golden);
+            }
+
+            if (specialKey == "suspicious") {
+              BeginSection(WorldSnapshot::Section::Suspicious);
+              return ReadCells(WorldSnapshot::Section::Suspicious);
+            }
+
+            return SkipValue();
+          });
+        }
+
+        return SkipValue();
+      });
+
+      // Nothing but whitespace may follow the state
+      SkipWhitespace();
+      return isRead && !HasByte();
+    }
+
+    inline uint64_t GetPosition() const noexcept { return m_Position; }
+
+  private:
+    bool ReadSnakes() {
+      WorldSnapshot& snapshot = m_Snapshot;
+      BeginSection(WorldSnapshot::Section::SnakeBodies);
+      return ReadArray([this, &snapshot]() {
+        uint32_t snake = snapshot.GetSnakeCount();
+        snapshot.m_SnakeStatus.push_back(SnakeStatus::Dead);
+        snapshot.m_SnakeDirections.push_back(Coords{ 0, 0, 0 });
+        snapshot.m_SnakeOldDirections.push_back(Coords{ 0, 0, 0 });
+        snapshot.m_SnakeDeathCounts.push_back(0);
+        snapshot.m_SnakeReviveRemainMs.push_back(0);
+        if (snapshot.m_SnakeIds.size() <= snake) { snapshot.m_SnakeIds.emplace_back(); }
+        snapshot.m_SnakeIds[snake].clear();
+
+        bool isRead = ReadObject([this, &snapshot, snake](std::string_view key) {
+          if (key == "geometry") { return ReadCells(WorldSnapshot::Section::SnakeBodies); }
+          if (key == "status") { return ReadStatus(snapshot.m_SnakeStatus[snake]); }
+          if (key == "direction") { return ReadCoords(snapshot.m_SnakeDirections[snake]); }
+          if (key == "oldDirection") { return ReadCoords(snapshot.m_SnakeOldDirections[snake]); }
+          if (key == "deathCount") { return ReadNumber(snapshot.m_SnakeDeathCounts[snake]); }
+          if (key == "reviveRemainMs") { return ReadNumber(snapshot.m_SnakeReviveRemainMs[snake]); }
+
+          if (key == "id") {
+            std::string_view id;
+            if (!ReadString(id)) { return false; }
+
+            snapshot.m_SnakeIds[snake].assign(id);
+            return true;
+          }
+
+          return SkipValue();
+        });
+
+        snapshot.m_SnakeOffsets.push_back(GetCount(WorldSnapshot::Section::SnakeBodies));
+        return isRead;
+      });
+    }
+
+    bool ReadEnemies() {
+      WorldSnapshot& snapshot = m_Snapshot;
+      BeginSection(WorldSnapshot::Section::EnemyBodies);
+      return ReadArray([this, &snapshot]() {
+        snapshot.m_EnemyStatus.push_back(SnakeStatus::Dead);
+        snapshot.m_EnemyKills.push_back(0);
+
+        bool isRead = ReadObject([this, &snapshot](std::string_view key) {
+          if (key == "geometry") { return ReadCells(WorldSnapshot::Section::EnemyBodies); }
+          if (key == "status") { return ReadStatus(snapshot.m_EnemyStatus.back()); }
+          if (key == "kills") { return ReadNumber(snapshot.m_EnemyKills.back()); }
+          return SkipValue();
+        });
+
+        snapshot.m_EnemyOffsets.push_back(GetCount(WorldSnapshot::Section::EnemyBodies));
+        return isRead;
+      });
+    }
+
+    bool ReadFood() {
+      WorldSnapshot& snapshot = m_Snapshot;
+      BeginSection(WorldSnapshot::Section::Food);
+      return ReadArray([this, &snapshot]() {
+        snapshot.m_FoodPoints.push_back(0);
+        snapshot.m_FoodTypes.push_back(0);
+
+        return ReadObject([this, &snapshot](std::string_view key) {
+          if (key == "c") {
+            Coords coords;
+            if (!ReadCoords(coords)) { return false; }
+
+            AppendCell(WorldSnapshot::Section::Food, coords);
+            return true;
+          }
+
+          if (key == "points") { return ReadNumber(snapshot.m_FoodPoints.back()); }
+          if (key == "type") { return ReadNumber(snapshot.m_FoodTypes.back()); }
+          return SkipValue();
+        });
+      });
+    }
+
+    // Cells read before the map size are kept as triplets, WorldSnapshot::PackSections packs them afterwards
+    inline void BeginSection(WorldSnapshot::Section section) noexcept {
+      WorldSnapshot::Range& range = m_Snapshot.m_Sections[static_cast<uint8_t>(section)];
+      range.begin = static_cast<uint32_t>(m_Snapshot.m_Arena.size());
+      range.count = 0;
+      range.isPacked = m_Snapshot.m_CellCount != 0;
+    }
+
+    inline void AppendCell(WorldSnapshot::Section section, const Coords& pos) {
+      WorldSnapshot::Range& range = m_Snapshot.m_Sections[static_cast<uint8_t>(section)];
+      std::vector<uint32_t>& arena = m_Snapshot.m_Arena;
+      if (range.isPacked) {
+        arena.push_back(m_Snapshot.GetIndex(pos));
+      } else {
+        arena.insert(arena.end(), { static_cast<uint32_t>(pos.x), static_cast<uint32_t>(pos.y), static_cast<uint32_t>(pos.z) });
+      }
+
+      ++range.count;
+    }
+
+    inline uint32_t GetCount(WorldSnapshot::Section section) const noexcept {
+      return m_Snapshot.m_Sections[static_cast<uint8_t>(section)].count;
+    }
+
+    bool ReadCells(WorldSnapshot::Section section) {
+      return ReadArray([this, section]() {
+        Coords pos;
+        if (!ReadCoords(pos)) { return false; }
+
+        AppendCell(section, pos);
+        return true;
+      });
+    }
+
+    bool ReadCoords(Coords& pos) {
+      return Consume('[') && ReadNumber(pos.x) && Consume(',') && ReadNumber(pos.y) && Consume(',') && ReadNumber(pos.z) && Consume(']');
+    }
+
+    bool ReadStatus(SnakeStatus& status) {
+      std::string_view value;
+      if (!ReadString(value)) { return false; }
+
+      status = value == "alive" ? SnakeStatus::Alive : SnakeStatus::Dead;
+      return true;
+    }
+
+    // The whole number is taken before it is converted, so one split between two chunks is read in one piece.
+    // Fractions and exponents are skipped, every number in a state is an integer.
+    template <typename T>
+    bool ReadNumber(T& value) {
+      SkipWhitespace();
+      uint64_t begin = m_Position;
+      while (HasByte() && IsNumberChar(m_Json[m_Position])) { ++m_Position; }
+
+      int64_t number = 0;
+      auto [end, error] = std::from_chars(m_Json.data() + begin, m_Json.data() + m_Position, number);
+      if (error != std::errc()) { return false; }
+
+      value = static_cast<T>(number);
+      return true;
+    }
+
+    // Escape sequences are kept as they are, none of the values read here contains one
+    bool ReadString(std::string_view& value) {
+      if (!Consume('"')) { return false; }
+
+      uint64_t begin = m_Position;
+      while (HasByte() && m_Json[m_Position] != '"') {
+        if (m_Json[m_Position] == '\\') {
+          ++m_Position;
+          if (!HasByte()) { return false; }
+        }
+        ++m_Position;
+      }
+
+      if (!HasByte()) { return false; }
+
+      value = m_Json.substr(begin, m_Position - begin);
+      ++m_Position;
+      return true;
+    }
+
+    bool SkipValue() {
+      SkipWhitespace();
+      if (!HasByte()) { return false; }
+
+      switch (m_Json[m_Position]) {
+        case '{': return ReadObject([this](std::string_view) { return SkipValue(); });
+        case '[': return ReadArray([this]() { return SkipValue(); });
+        case '"': {
+          std::string_view value;
+          return ReadString(value);
+        }
+        default: break;
+      }
+
+      uint64_t begin = m_Position;
+      while (HasByte() && std::string_view(",]} \t\r\n").find(m_Json[m_Position]) == std::string_view::npos) { ++m_Position; }
+      return m_Position != begin;
+    }
+
+    // Calls readField(key) with the position on the value of every field
+    template <typename Function>
+    bool ReadObject(Function&& readField) {
+      if (!Consume('{')) { return false; }
+      if (Consume('}')) { return true; }
+
+      // The key is copied out, waiting for the value may move the json
+      std::array<char, MAX_KEY_LENGTH> keyBuffer;
+      do {
+        std::string_view key;
+        if (!ReadString(key)) { return false; }
+
+        uint64_t keyLength = key.size() <= keyBuffer.size() ? key.size() : 0;
+        std::copy_n(key.data(), keyLength, keyBuffer.data());
+        if (!Consume(':') || !readField(std::string_view(keyBuffer.data(), keyLength))) { return false; }
+      } while (Consume(','));
+
+      return Consume('}');
+    }
+
+    // Calls readElement() with the position on every element
+    template <typename Function>
+    bool ReadArray(Function&& readElement) {
+      if (!Consume('[')) { return false; }
+      if (Consume(']')) { return true; }
+
+      do {
+        if (!readElement()) { return false; }
+      } while (Consume(','));
+
+      return Consume(']');
+    }
+
+    inline bool Consume(char c) noexcept {
+      SkipWhitespace();
+      if (!HasByte() || m_Json[m_Position] != c) { return false; }
+
+      ++m_Position;
+      return true;
+    }
+
+    inline void SkipWhitespace() noexcept {
+      while (HasByte() && (m_Json[m_Position] == ' ' || m_Json[m_Position] == '\n'
+             || m_Json[m_Position] == '\r' || m_Json[m_Position] == '\t')) {
+        ++m_Position;
+      }
+    }
+
+    // True when the byte at the position is there, waits for more of a json that is still arriving
+    inline bool HasByte() {
+      if (m_Position < m_Json.size()) { return true; }
+      if (m_ReadMore == nullptr) { return false; }
+
+      m_Json = (*m_ReadMore)(m_Position);
+      return m_Position < m_Json.size();
+    }
+
+    static inline bool IsNumberChar(char c) noexcept {
+      return (c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-';
+    }
+
+  private:
+    std::string_view m_Json;
+    uint64_t m_Position = 0;
+    WorldSnapshot& m_Snapshot;
+    const WorldSnapshot::ReadMore* m_ReadMore = nullptr;
+  };
+
+  bool WorldSnapshot::Parse(std::string_view json) {
+    Clear();
+
+    SnapshotReader reader(json, *this);
+    if (!reader.ReadState()) {
+      CORE_ERROR("Failed to parse world snapshot at offset {}!", reader.GetPosition());
+      Clear();
+      return false;
+    }
+
+    PackSections();
+    return true;
+  }
+
+  bool WorldSnapshot::Parse(const ReadMore& readMore) {
+    Clear();
+
+    SnapshotReader reader(std::string_view(), *this, &readMore);
+    if (!reader.ReadState()) {
+      CORE_ERROR("Failed to parse world snapshot at offset {}!", reader.GetPosition());
+      Clear();
+      return false;
+    }
+
+    PackSections();
+    return true;
+  }
+
+  void WorldSnapshot::Clear() noexcept {
+    SetMapSize(Coords{ 0, 0, 0 });
+    m_Name.clear();
+    m_Points = 0;
+    m_Turn = 0;
+    m_TickRemainMs = 0;
+    m_ReviveTimeoutSec = 0;
+    m_Errors.clear();
+
+    m_Arena.clear();
+    m_Sections.fill(Range{});
+    m_FoodPoints.clear();
+    m_FoodTypes.clear();
+
+    // The id strings are kept to reuse their buffers, the snake count comes from the status array
+    m_SnakeOffsets.assign(1, 0);
+    m_SnakeStatus.clear();
+    m_SnakeDirections.clear();
+    m_SnakeOldDirections.clear();
+    m_SnakeDeathCounts.clear();
+    m_SnakeReviveRemainMs.clear();
+
+    m_EnemyOffsets.assign(1, 0);
+    m_EnemyStatus.clear();
+    m_EnemyKills.clear();
+  }
+
+  void WorldSnapshot::CopyTo(GameState& gameState) const {
+    gameState.mapSize = m_MapSize;
+    gameState.name.assign(m_Name);
+    gameState.points = m_Points;
+    gameState.turn = m_Turn;
+    gameState.tickRemainMs = m_TickRemainMs;
+    gameState.reviveTimeoutSec = m_ReviveTimeoutSec;
+    gameState.errors.assign(m_Errors.begin(), m_Errors.end());
+
+    CopyCells(GetFences(), gameState.fences);
+
+    // Resizing keeps the geometry buffers of the snakes that are still there
+    gameState.snakes.resize(GetSnakeCount());
+    for (uint32_t i = 0; i < GetSnakeCount(); ++i) {
+      PlayerSnake& snake = gameState.snakes[i];
+      snake.id.assign(m_SnakeIds[i]);
+      CopyCells(GetSnakeBody(i), snake.geometry);
+      snake.direction = m_SnakeDirections[i];
+      snake.oldDirection = m_SnakeOldDirections[i];
+      snake.deathCount = m_SnakeDeathCounts[i];
+      snake.status = m_SnakeStatus[i];
+      snake.reviveRemainMs = m_SnakeReviveRemainMs[i];
+    }
+
+    gameState.enemies.resize(GetEnemyCount());
+    for (uint32_t i = 0; i < GetEnemyCount(); ++i) {
+      EnemySnake& enemy = gameState.enemies[i];
+      CopyCells(GetEnemyBody(i), enemy.geometry);
+      enemy.status = m_EnemyStatus[i];
+      enemy.kills = m_EnemyKills[i];
+    }
+
+    std::span<const uint32_t> foods = GetFood();
+    gameState.food.clear();
+    for (uint64_t i = 0; i < foods.size(); ++i) {
+      if (!IsValidCell(foods[i])) { continue; }
+      gameState.food.push_back(Food{ .coords = GetCoords(foods[i]), .points = m_FoodPoints[i], .type = m_FoodTypes[i] });
+    }
+
+    CopyCells(GetGoldenFood(), gameState.specialFood.golden);
+    CopyCells(GetSuspiciousFood(), gameState.specialFood.suspicious);
+  }
+
+  void WorldSnapshot::CopyCells(std::span<const uint32_t> cells, std::vector<Coords>& coords) const {
+    coords.clear();
+    for (uint32_t cell : cells) {
+      if (IsValidCell(cell)) { coords.push_back(GetCoords(cell)); }
+    }
+  }
+
+  void WorldSnapshot::SetMapSize(const Coords& mapSize) noexcept {
+    m_MapSize = Coords{ std::max(mapSize.x, 0), std::max(mapSize.y, 0), std::max(mapSize.z, 0) };
+    m_StrideY = static_cast<uint32_t>(m_MapSize.x);
+    m_StrideZ = static_cast<uint32_t>(m_MapSize.x) * static_cast<uint32_t>(m_MapSize.y);
+    m_CellCount = m_StrideZ * static_cast<uint32_t>(m_MapSize.z);
+  }
+
+  void WorldSnapshot::PackSections() noexcept {
+    for (Range& range : m_Sections) {
+      if (range.isPacked) { continue; }
+
+      // Every cell shrinks from three words to one, so packing front to back never overwrites a triplet still to be read
+      uint32_t* cells = m_Arena.data() + range.begin;
+      for (uint32_t i = 0; i < range.count; ++i) {
+        Coords pos{ static_cast<int32_t>(cells[i * 3]), static_cast<int32_t>(cells[i * 3 + 1]), static_cast<int32_t>(cells[i * 3 + 2]) };
+        cells[i] = GetIndex(pos);
+      }
+
+      range.isPacked = true;
+    }
+  }
+}
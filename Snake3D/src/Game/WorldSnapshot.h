@@ -0,0 +1,150 @@
+#pragma once
+
+#include "pch.h"
+
+#include <span>
+
+namespace Snake {
+  // Structure-of-arrays copy of one server state, parsed straight from the json. Cells are packed into indices laid out
+  // like OccupancyGrid and written into one arena, the bodies of all snakes back to back with an offset per snake.
+  // The arena and every other array keep their capacity between ticks, so a steady stream of states parses without
+  // allocating, and copying a snapshot is a handful of flat copies.
+  class WorldSnapshot {
+  public:
+    // Blocks until bytes past the position have arrived, or the body is complete, and returns everything received so far.
+    // The returned view stays valid until the next call.
+    using ReadMore = std::function<std::string_view(uint64_t position)>;
+
+    WorldSnapshot() = default;
+
+    // Replaces the snapshot with the state in json, returns false when json is not a valid state
+    bool Parse(std::string_view json);
+
+    // Same as above for a body that is still arriving, every array is filled while the rest of it downloads
+    bool Parse(const ReadMore& readMore);
+    void Clear() noexcept;
+
+    // Expands the snapshot into gameState, reusing the buffers it already holds. Snake keys are left as they are.
+    // Cells outside of the map are dropped.
+    void CopyTo(GameState& gameState) const;
+
+    // Bodies that are not a state, like the error sent between rounds, parse as a snapshot without a map
+    inline bool HasMap() const noexcept { return m_CellCount != 0; }
+
+    inline std::span<const uint32_t> GetFences() const noexcept { return GetSection(Section::Fences); }
+
+    // Food cells with their points and types at the same positions
+    inline std::span<const uint32_t> GetFood() const noexcept { return GetSection(Section::Food); }
+    inline std::span<const uint32_t> GetFoodPoints() const noexcept { return m_FoodPoints; }
+    inline std::span<const uint32_t> GetFoodTypes() const noexcept { return m_FoodTypes; }
+
+    inline std::span<const uint32_t> GetGoldenFood() const noexcept { return GetSection(Section::Golden); }
+    inline std::span<const uint32_t> GetSuspiciousFood() const noexcept { return GetSection(Section::Suspicious); }
+
+    inline uint32_t GetSnakeCount() const noexcept { return static_cast<uint32_t>(m_SnakeStatus.size()); }
+    inline std::span<const uint32_t> GetSnakeBody(uint32_t snake) const noexcept { return GetBody(Section::SnakeBodies, m_SnakeOffsets, snake); }
+    inline SnakeStatus GetSnakeStatus(uint32_t snake) const noexcept { return m_SnakeStatus[snake]; }
+    inline const Coords& GetSnakeDirection(uint32_t snake) const noexcept { return m_SnakeDirections[snake]; }
+    inline const Coords& GetSnakeOldDirection(uint32_t snake) const noexcept { return m_SnakeOldDirections[snake]; }
+    inline const std::string& GetSnakeId(uint32_t snake) const noexcept { return m_SnakeIds[snake]; }
+    inline uint32_t GetSnakeDeathCount(uint32_t snake) const noexcept { return m_SnakeDeathCounts[snake]; }
+    inline uint32_t GetSnakeReviveRemainMs(uint32_t snake) const noexcept { return m_SnakeReviveRemainMs[snake]; }
+
+    inline uint32_t GetEnemyCount() const noexcept { return static_cast<uint32_t>(m_EnemyStatus.size()); }
+    inline std::span<const uint32_t> GetEnemyBody(uint32_t enemy) const noexcept { return GetBody(Section::EnemyBodies, m_EnemyOffsets, enemy); }
+    inline SnakeStatus GetEnemyStatus(uint32_t enemy) const noexcept { return m_EnemyStatus[enemy]; }
+    inline uint32_t GetEnemyKills(uint32_t enemy) const noexcept { return m_EnemyKills[enemy]; }
+
+    // Cells outside of the map are stored as an index past the last cell
+    inline bool IsValidCell(uint32_t index) const noexcept { return index < m_CellCount; }
+
+    inline uint32_t GetIndex(const Coords& pos) const noexcept {
+      if (static_cast<uint32_t>(pos.x) >= static_cast<uint32_t>(m_MapSize.x) || static_cast<uint32_t>(pos.y) >= static_cast<uint32_t>(m_MapSize.y)
+          || static_cast<uint32_t>(pos.z) >= static_cast<uint32_t>(m_MapSize.z)) {
+        return INVALID_CELL;
+      }
+
+      return static_cast<uint32_t>(pos.x) + static_cast<uint32_t>(pos.y) * m_StrideY + static_cast<uint32_t>(pos.z) * m_StrideZ;
+    }
+
+    inline Coords GetCoords(uint32_t index) const noexcept {
+      return Coords{
+        .x = static_cast<int32_t>(index % m_StrideY),
+        .y = static_cast<int32_t>((index % m_StrideZ) / m_StrideY),
+        .z = static_cast<int32_t>(index / m_StrideZ)
+      };
+    }
+
+    inline const Coords& GetMapSize() const noexcept { return m_MapSize; }
+    inline const std::string& GetName() const noexcept { return m_Name; }
+    inline uint32_t GetPoints() const noexcept { return m_Points; }
+    inline uint32_t GetTurn() const noexcept { return m_Turn; }
+    inline uint32_t GetTickRemainMs() const noexcept { return m_TickRemainMs; }
+    inline uint32_t GetReviveTimeoutSec() const noexcept { return m_ReviveTimeoutSec; }
+    inline const std::vector<std::string>& GetErrors() const noexcept { return m_Errors; }
+
+  private:
+    static constexpr uint32_t INVALID_CELL = std::numeric_limits<uint32_t>::max();
+
+    enum class Section : uint8_t {
+      Fences, Food, Golden, Suspicious, SnakeBodies, EnemyBodies, Count
+    };
+
+    // Part of the arena holding one array. Cells that arrive before the map size are kept as raw x, y, z
+    // triplets and packed once the whole state has been read.
+    struct Range {
+      uint32_t begin = 0;
+      uint32_t count = 0;
+      bool isPacked = true;
+    };
+
+    inline std::span<const uint32_t> GetSection(Section section) const noexcept {
+      const Range& range = m_Sections[static_cast<uint8_t>(section)];
+      return std::span<const uint32_t>(m_Arena.data() + range.begin, range.count);
+    }
+
+    inline std::span<const uint32_t> GetBody(Section section, const std::vector<uint32_t>& offsets, uint32_t snake) const noexcept {
+      return GetSection(section).subspan(offsets[snake], offsets[snake + 1] - offsets[snake]);
+    }
+
+    void SetMapSize(const Coords& mapSize) noexcept;
+    void CopyCells(std::span<const uint32_t> cells, std::vector<Coords>& coords) const;
+
+    // Packs the sections that were read as triplets
+    void PackSections() noexcept;
+
+  private:
+    Coords m_MapSize{ 0, 0, 0 };
+    uint32_t m_StrideY = 0;
+    uint32_t m_StrideZ = 0;
+    uint32_t m_CellCount = 0;
+
+    std::string m_Name;
+    uint32_t m_Points = 0;
+    uint32_t m_Turn = 0;
+    uint32_t m_TickRemainMs = 0;
+    uint32_t m_ReviveTimeoutSec = 0;
+    std::vector<std::string> m_Errors;
+
+    std::vector<uint32_t> m_Arena;
+    std::array<Range, static_cast<uint8_t>(Section::Count)> m_Sections{};
+
+    std::vector<uint32_t> m_FoodPoints;
+    std::vector<uint32_t> m_FoodTypes;
+
+    // Offsets into the body sections in cells, one more than there are snakes
+    std::vector<uint32_t> m_SnakeOffsets;
+    std::vector<SnakeStatus> m_SnakeStatus;
+    std::vector<Coords> m_SnakeDirections;
+    std::vector<Coords> m_SnakeOldDirections;
+    std::vector<std::string> m_SnakeIds;
+    std::vector<uint32_t> m_SnakeDeathCounts;
+    std::vector<uint32_t> m_SnakeReviveRemainMs;
+
+    std::vector<uint32_t> m_EnemyOffsets;
+    std::vector<SnakeStatus> m_EnemyStatus;
+    std::vector<uint32_t> m_EnemyKills;
+
+    friend class SnapshotReader;
+  };
+}
@@ -37,7 +37,7 @@ namespace Snake {
     }
   }
 
-  void Renderer::Render(Timestep deltaTime, const GameState& gameState) {
+  void Renderer::Render(Timestep deltaTime, const WorldSnapshot& snapshot) {
     BeginDrawing();
     ClearBackground(BLACK);
 
@@ -48,31 +48,22 @@ namespace Snake {
     DrawSkybox();
 
     if (m_ShowGrid) {
-      DrawSectorGrid(gameState);
-      DrawSimplifiedGrid(gameState.mapSize.x + 1);
+      DrawSectorGrid(snapshot.GetMapSize());
+      DrawSimplifiedGrid(snapshot.GetMapSize().x + 1);
     }
 
-    // Batch render food using instancing
-    for (const Food& food : gameState.food) {
-      Vector3 position{
-        static_cast<float>(food.coords.x),
-        static_cast<float>(food.coords.y),
-        static_cast<float>(food.coords.z)
-      };
+    m_FoodIndex.Build(snapshot);
+    RenderFood(m_FoodIndex);
 
-      if (IsPointInFrustum(position)) {
-        DrawModelEx(m_SphereModel, position, { 0, 1, 0 }, 0.0f, { 1.0f, 1.0f, 1.0f }, WHITE);
-      }
-    }
-
-    RenderSpecialFood(gameState.specialFood);
-
-    RenderSnakes(gameState.enemies, gameState.snakes);
+    RenderSnakes(snapshot);
 
     rlDisableDepthMask();
 
     // Batch render fences
-    for (const Coords& fence : gameState.fences) {
+    for (uint32_t cell : snapshot.GetFences()) {
+      if (!snapshot.IsValidCell(cell)) { continue; }
+
+      Coords fence = snapshot.GetCoords(cell);
       Vector3 position{
         static_cast<float>(fence.x),
         static_cast<float>(fence.y),
@@ -88,7 +79,7 @@ namespace Snake {
     
     EndMode3D();
 
-    DrawHUD(gameState, deltaTime);
+    DrawHUD(snapshot, deltaTime);
 
     EndDrawing();
   }
@@ -177,13 +168,13 @@ namespace Snake {
     }
   }
 
-  void Renderer::DrawSectorGrid(const GameState& gameState) {
+  void Renderer::DrawSectorGrid(const Coords& mapSize) {
     constexpr Color SECTOR_COLOR{ 30, 30, 30, 100 };
     constexpr Color BOUNDING_BOX_COLOR{ 255, 0, 0, 200 };
     
-    float mapSizeX = static_cast<float>(gameState.mapSize.x);
-    float mapSizeY = static_cast<float>(gameState.mapSize.y);
-    float mapSizeZ = static_cast<float>(gameState.mapSize.z);
+    float mapSizeX = static_cast<float>(mapSize.x);
+    float mapSizeY = static_cast<float>(mapSize.y);
+    float mapSizeZ = static_cast<float>(mapSize.z);
 
     for (float x = 0; x < mapSizeX; x += SECTOR_SIZE) {
       for (float y = 0; y < mapSizeY; y += SECTOR_SIZE) {
@@ -201,57 +192,54 @@ namespace Snake {
     DrawCubeWires(mapCenter, mapSizeX, mapSizeY, mapSizeZ, BOUNDING_BOX_COLOR);
   }
 
-  void Renderer::RenderSpecialFood(const SpecialFood& specialFood) {
-    for (const Coords& golden : specialFood.golden) {
+  void Renderer::RenderFood(const FoodIndex& foodIndex) {
+    // Batch render food using instancing, special food is drawn once in its own color
+    for (const FoodIndex::Entry& food : foodIndex.GetEntries()) {
       Vector3 position{
-        static_cast<float>(golden.x),
-        static_cast<float>(golden.y),
-        static_cast<float>(golden.z)
+        static_cast<float>(food.coords.x),
+        static_cast<float>(food.coords.y),
+        static_cast<float>(food.coords.z)
       };
 
-      if (IsPointInFrustum(position)) {
-        DrawModelEx(m_SphereModel, position, { 0, 1, 0 }, 0.0f, { 1.0f, 1.0f, 1.0f }, GOLD);
-      }
-    }
-
-    for (const Coords& suspicious : specialFood.suspicious) {
-      Vector3 position{
-        static_cast<float>(suspicious.x),
-        static_cast<float>(suspicious.y),
-        static_cast<float>(suspicious.z)
-      };
+      if (!IsPointInFrustum(position)) { continue; }
 
-      if (IsPointInFrustum(position)) {
-        DrawModelEx(m_SphereModel, position, { 0, 1, 0 }, 0.0f, { 1.0f, 1.0f, 1.0f }, GREEN);
+      Color color = WHITE;
+      switch (food.kind) {
+        case FoodKind::Golden: color = GOLD; break;
+        case FoodKind::Suspicious: color = GREEN; break;
+        default: break;
       }
+
+      DrawModelEx(m_SphereModel, position, { 0, 1, 0 }, 0.0f, { 1.0f, 1.0f, 1.0f }, color);
     }
   }
 
-  void Renderer::RenderSnakes(const std::vector<EnemySnake>& enemies, const std::vector<PlayerSnake>& players) {
-    for (const EnemySnake& enemy : enemies) {
-      if (enemy.status == "alive") {
-        DrawSnakeOptimized(enemy.geometry, RED, false);
+  void Renderer::RenderSnakes(const WorldSnapshot& snapshot) {
+    for (uint32_t i = 0; i < snapshot.GetEnemyCount(); ++i) {
+      if (snapshot.GetEnemyStatus(i) == SnakeStatus::Alive) {
+        DrawSnakeOptimized(snapshot, snapshot.GetEnemyBody(i), RED, false);
       }
     }
 
-    for (const PlayerSnake& snake : players) {
-      if (snake.status == "alive") {
-        DrawSnakeOptimized(snake.geometry, BLUE, true);
+    for (uint32_t i = 0; i < snapshot.GetSnakeCount(); ++i) {
+      if (snapshot.GetSnakeStatus(i) == SnakeStatus::Alive) {
+        DrawSnakeOptimized(snapshot, snapshot.GetSnakeBody(i), BLUE, true);
       }
     }
   }
 
-  void Renderer::DrawSnakeOptimized(const std::vector<Coords>& geometry, Color color, bool isPlayer) {
-    if (geometry.empty()) { return; }
+  void Renderer::DrawSnakeOptimized(const WorldSnapshot& snapshot, std::span<const uint32_t> body, Color color, bool isPlayer) {
+    if (body.empty()) { return; }
 
+    Coords head = snapshot.GetCoords(body.front());
     Vector3 position{
-      static_cast<float>(geometry.front().x),
-      static_cast<float>(geometry.front().y),
-      static_cast<float>(geometry.front().z)
+      static_cast<float>(head.x),
+      static_cast<float>(head.y),
+      static_cast<float>(head.z)
     };
 
     // Draw head
-    if (IsCubeInFrustum(position, 1.0f)) {
+    if (snapshot.IsValidCell(body.front()) && IsCubeInFrustum(position, 1.0f)) {
       DrawModelEx(m_CubeModel, position, { 0, 1, 0 }, 0.0f, { 1.0f, 1.0f, 1.0f }, color);
     }
 
@@ -259,11 +247,14 @@ namespace Snake {
     Vector3 scale = { 0.8f, 0.8f, 0.8f };
     Color bodyColor = ColorAlpha(color, 0.8f);
 
-    for (uint64_t i = 1; i < geometry.size(); ++i) {
+    for (uint64_t i = 1; i < body.size(); ++i) {
+      if (!snapshot.IsValidCell(body[i])) { continue; }
+
+      Coords segment = snapshot.GetCoords(body[i]);
       position = {
-        static_cast<float>(geometry[i].x),
-        static_cast<float>(geometry[i].y),
-        static_cast<float>(geometry[i].z)
+        static_cast<float>(segment.x),
+        static_cast<float>(segment.y),
+        static_cast<float>(segment.z)
       };
 
       if (IsCubeInFrustum(position, 1.0f)) {
@@ -272,11 +263,11 @@ namespace Snake {
     }
   }
 
-  void Renderer::DrawHUD(const GameState& gameState, Timestep deltaTime) {
+  void Renderer::DrawHUD(const WorldSnapshot& snapshot, Timestep deltaTime) {
     static char buffer[128];
 
     snprintf(buffer, sizeof(buffer), "Points: %d\nTurn: %d\nTime Remaining: %dms\nFPS: %d",
-             gameState.points, gameState.turn, gameState.tickRemainMs, static_cast<uint32_t>(deltaTime.GetFramerate()));
+             snapshot.GetPoints(), snapshot.GetTurn(), snapshot.GetTickRemainMs(), static_cast<uint32_t>(deltaTime.GetFramerate()));
 
     DrawText(buffer, 10, 10, 20, WHITE);
     DrawText("ESC - Exit | F2 - Show/Hide grid\nWASD - Move | Mouse - Rotate | Scroll - FOV", 10, GetScreenHeight() - 50, 20, WHITE);
@@ -2,6 +2,8 @@
 
 #include "pch.h"
 
+#include "Game/FoodIndex.h"
+
 #include <raylib.h>
 
 namespace Snake {
@@ -16,7 +18,7 @@ namespace Snake {
 
     void Init(std::string_view windowName, uint32_t width, uint32_t height);
     void Update(Timestep deltaTime);
-    void Render(Timestep deltaTime, const GameState& gameState);
+    void Render(Timestep deltaTime, const WorldSnapshot& snapshot);
 
     inline bool ShouldStop() const noexcept { return WindowShouldClose(); }
 
@@ -31,11 +33,11 @@ namespace Snake {
 
     void DrawSkybox();
     void DrawSimplifiedGrid(uint32_t size);
-    void DrawSectorGrid(const GameState& gameState);
-    void RenderSpecialFood(const SpecialFood& specialFood);
-    void RenderSnakes(const std::vector<EnemySnake>& enemies, const std::vector<PlayerSnake>& players);
-    void DrawSnakeOptimized(const std::vector<Coords>& geometry, Color color, bool isPlayer);
-    void DrawHUD(const GameState& gameState, Timestep deltaTime);
+    void DrawSectorGrid(const Coords& mapSize);
+    void RenderFood(const FoodIndex& foodIndex);
+    void RenderSnakes(const WorldSnapshot& snapshot);
+    void DrawSnakeOptimized(const WorldSnapshot& snapshot, std::span<const uint32_t> body, Color color, bool isPlayer);
+    void DrawHUD(const WorldSnapshot& snapshot, Timestep deltaTime);
 
     
     bool IsPointInFrustum(const Vector3& point) const noexcept;
@@ -70,6 +72,8 @@ namespace Snake {
     Model m_SphereModel;
     bool m_ShowGrid = false;
 
+    FoodIndex m_FoodIndex;
+
     Mesh m_SkyboxMesh;
     Model m_SkyboxModel;
 
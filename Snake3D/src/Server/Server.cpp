@@ -2,9 +2,35 @@
 
 #include "Game/GameObjects.h"
 
+#include <chrono>
+#include <cstdio>
+
 constexpr const char* MOVE_ENDPOINT = "player/move";
 
+// Weight of the newest sample in the round-trip estimate
+constexpr double ROUND_TRIP_SMOOTHING = 0.2;
+
+// Body of a state request, no snake changes its direction
+constexpr const char* FETCH_BODY = R"({"snakes":[]})";
+
 namespace Snake {
+  // Server times look like 2024-11-16T12:00:00.250Z, the fraction is optional
+  static std::optional<std::chrono::sys_time<std::chrono::milliseconds>> ParseServerTime(const std::string& time) {
+    int32_t year = 0;
+    uint32_t month = 0;
+    uint32_t day = 0;
+    uint32_t hours = 0;
+    uint32_t minutes = 0;
+    double seconds = 0.0;
+    if (std::sscanf(time.c_str(), "%d-%u-%uT%u:%u:%lf", &year, &month, &day, &hours, &minutes, &seconds) != 6) { return std::nullopt; }
+
+    std::chrono::year_month_day date{ std::chrono::year(year), std::chrono::month(month), std::chrono::day(day) };
+    if (!date.ok()) { return std::nullopt; }
+
+    return std::chrono::sys_days(date) + std::chrono::hours(hours) + std::chrono::minutes(minutes)
+      + std::chrono::milliseconds(static_cast<int64_t>(seconds * 1000.0));
+  }
+
   void Server::Connect(std::string_view url, std::string_view token) {
     if (url.empty()) {
       CORE_ASSERT(false, "Failed to connect to the server: url is empty!");
@@ -18,77 +44,304 @@ namespace Snake {
 
     if (url == m_Url && token == m_Token && m_State == State::Connected) { return; }
 
+    StopIo();
+
     m_Url = url;
     m_Token = token;
 
-    m_Session.SetUrl(std::format("{}/{}", url, MOVE_ENDPOINT));
-    m_Session.SetHeader({
-      { "X-Auth-Token", m_Token},
-      { "Content-Type", "application/json" }
-    });
+    for (cpr::Session* session : { &m_FetchSession, &m_SendSession }) {
+      session->SetUrl(std::format("{}/{}", url, MOVE_ENDPOINT));
+      session->SetHeader({
+        { "X-Auth-Token", m_Token},
+        { "Content-Type", "application/json" }
+      });
+    }
+    m_FetchSession.SetBody(cpr::Body(FETCH_BODY));
+
+    // Bodies are appended to the persistent buffer instead of a new string per response, moves answers are dropped
+    m_FetchSession.SetWriteCallback(cpr::WriteCallback{ [this](std::string_view data, intptr_t) { return ReceiveChunk(data); } });
+    m_SendSession.SetWriteCallback(cpr::WriteCallback{ [](std::string_view, intptr_t) { return true; } });
+
+    m_StopIo = false;
+    m_StopStream = false;
+    m_FetchThread = std::thread(&Server::FetchLoop, this);
+    m_SendThread = std::thread(&Server::SendLoop, this);
+    m_ParseThread = std::thread(&Server::ParseLoop, this);
 
     m_State = State::Connected;
   }
 
   void Server::Disconnect() {
+    StopIo();
     m_State = State::Disconnected;
   }
 
-  void Server::Update() {
+  bool Server::Update() {
     if (m_State == State::Disconnected) {
       CORE_ASSERT(false, "Failed to update server: server is not connected!");
+      return false;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_IoMutex);
+      m_IsFetchRequested = true;
+    }
+    m_IoCondition.notify_all();
+
+    // Every request gets exactly one result, even when it failed
+    m_FetchResults.Wait();
+    FetchResult* result = m_FetchResults.GetReadSlot();
+    bool isFresh = result->isValid;
+    if (isFresh) {
+      // Swapping keeps the buffers of both states alive, the next fetch parses into the older one
+      std::swap(m_GameState, result->gameState);
+      {
+        // The old snapshot goes back to the fetch queue and is parsed into, no copy may still be reading it
+        std::lock_guard<std::mutex> lock(m_SnapshotMutex);
+        std::swap(m_Snapshot, result->snapshot);
+      }
+      m_ExpandMs = result->expandMs;
+      m_SnapshotTailMs = result->snapshotTailMs;
+    }
+    if (result->isValid || result->state == State::WaitingForNextGame) {
+      m_State = result->state;
+      m_NextRoundDelay = result->nextRoundDelay;
+    }
+    m_FetchResults.Pop();
+    return isFresh;
+  }
+
+  void Server::Send(std::string_view json) {
+    if (m_State == State::Disconnected) {
+      CORE_ASSERT(false, "Failed to post to the server: server is not connected!");
       return;
     }
 
-    cpr::Response response = m_Session.Post();
-    if (response.error) {
-      CORE_ASSERT(false, "Failed to update server: {}!", response.error.message);
+    if (m_State == State::WaitingForNextGame) { return; }
+
+    if (json.empty()) {
+      CORE_ASSERT(false, "Failed to post to the server: json is empty!");
       return;
     }
 
-    glz::error_ctx err = glz::read_json(m_GameState, response.text);
-    if (!err) {
-      m_State = State::Connected;
+    CORE_INFO("Sending json: {}", json);
+    {
+      std::lock_guard<std::mutex> lock(m_IoMutex);
+      m_PendingSend.assign(json);
+      m_HasPendingSend = true;
+    }
+    m_IoCondition.notify_all();
+  }
+
+  void Server::CopySnapshot(WorldSnapshot& snapshot) {
+    std::lock_guard<std::mutex> lock(m_SnapshotMutex);
+    snapshot = m_Snapshot;
+  }
+
+  void Server::FetchLoop() {
+    std::unique_lock<std::mutex> lock(m_IoMutex);
+    while (true) {
+      m_IoCondition.wait(lock, [this] { return m_StopIo || m_IsFetchRequested; });
+      if (m_StopIo) { return; }
+
+      m_IsFetchRequested = false;
+      lock.unlock();
+
+      // Update waits for this fetch, so the single slot it could still hold is always free
+      FetchResult* result = m_FetchResults.GetWriteSlot();
+      Fetch(*result);
+      m_FetchResults.Push();
+
+      lock.lock();
+    }
+  }
+
+  void Server::SendLoop() {
+    std::unique_lock<std::mutex> lock(m_IoMutex);
+    while (true) {
+      m_IoCondition.wait(lock, [this] { return m_StopIo || m_HasPendingSend; });
+      if (m_StopIo) { return; }
+
+      m_HasPendingSend = false;
+      m_SendBuffer.swap(m_PendingSend);
+      lock.unlock();
+
+      m_SendSession.SetBody(cpr::Body(m_SendBuffer));
+      cpr::Response response = Post(m_SendSession);
+      if (response.error) {
+        CORE_ERROR("Failed to post to the server: {}!", response.error.message);
+      }
+
+      lock.lock();
+    }
+  }
+
+  void Server::ParseLoop() {
+    WorldSnapshot::ReadMore readMore = [this](uint64_t position) { return WaitForBody(position); };
+
+    std::unique_lock<std::mutex> lock(m_StreamMutex);
+    while (true) {
+      m_StreamCondition.wait(lock, [this] { return m_StopStream || (m_StreamTarget != nullptr && !m_IsSnapshotParsed); });
+      if (m_StopStream) { return; }
+
+      WorldSnapshot* snapshot = m_StreamTarget;
+      lock.unlock();
+
+      bool isValid = snapshot->Parse(readMore);
+
+      lock.lock();
+      m_IsSnapshotValid = isValid;
+      m_IsSnapshotParsed = true;
+      m_StreamCondition.notify_all();
+    }
+  }
+
+  bool Server::ReceiveChunk(std::string_view data) {
+    {
+      std::unique_lock<std::mutex> lock(m_StreamMutex);
+
+      // Growing moves the buffer, which is only safe while the parse thread waits for more of it or is done reading
+      if (m_ReceiveBuffer.size() + data.size() > m_ReceiveBuffer.capacity()) {
+        m_StreamCondition.wait(lock, [this] { return m_IsParserWaiting || m_IsSnapshotParsed || m_StopStream; });
+      }
+
+      m_ReceiveBuffer.append(data);
+    }
+
+    m_StreamCondition.notify_all();
+    return true;
+  }
+
+  std::string_view Server::WaitForBody(uint64_t position) {
+    std::unique_lock<std::mutex> lock(m_StreamMutex);
+    m_IsParserWaiting = true;
+    m_StreamCondition.notify_all();
+
+    m_StreamCondition.wait(lock, [this, position] { return m_ReceiveBuffer.size() > position || m_IsBodyComplete || m_StopStream; });
+    m_IsParserWaiting = false;
+
+    // A stopped stream ends the json where it is, the parse fails and the parse thread gets to see the stop
+    return m_StopStream ? std::string_view(m_ReceiveBuffer).substr(0, position) : std::string_view(m_ReceiveBuffer);
+  }
+
+  void Server::BeginSnapshot(WorldSnapshot& snapshot) {
+    {
+      std::lock_guard<std::mutex> lock(m_StreamMutex);
+      m_ReceiveBuffer.clear();
+      m_StreamTarget = &snapshot;
+      m_IsBodyComplete = false;
+      m_IsSnapshotParsed = false;
+      m_IsSnapshotValid = false;
+    }
+
+    m_StreamCondition.notify_all();
+  }
+
+  bool Server::FinishSnapshot() {
+    std::unique_lock<std::mutex> lock(m_StreamMutex);
+    m_IsBodyComplete = true;
+    m_StreamCondition.notify_all();
+
+    m_StreamCondition.wait(lock, [this] { return m_IsSnapshotParsed || m_StopStream; });
+    m_StreamTarget = nullptr;
+    return m_IsSnapshotParsed && m_IsSnapshotValid;
+  }
+
+  void Server::Fetch(FetchResult& result) {
+    result.isValid = false;
+    result.state = State::Connected;
+    result.nextRoundDelay.reset();
+
+    // The snapshot is parsed on the parse thread while the body downloads
+    BeginSnapshot(result.snapshot);
+    cpr::Response response = Post(m_FetchSession);
+
+    Utils::Timer tailTimer;
+    tailTimer.Start();
+    bool isSnapshotValid = FinishSnapshot();
+    tailTimer.Stop();
+    result.snapshotTailMs = tailTimer.GetElapsedMilliSec();
+
+    if (response.error) {
+      CORE_ERROR("Failed to update server: {}!", response.error.message);
       return;
     }
 
-    CORE_ERROR("Error while updating server: Failed to parse server response: {}!", glz::format_error(err, response.text));
+    // The body was parsed once, while it downloaded. The planner state is expanded from the snapshot here,
+    // the update thread only picks up the result.
+    if (isSnapshotValid && result.snapshot.HasMap()) {
+      Utils::Timer timer;
+      timer.Start();
+
+      result.snapshot.CopyTo(result.gameState);
+      for (PlayerSnake& snake : result.gameState.snakes) {
+        snake.key = m_SnakeIds.Intern(snake.id);
+      }
+
+      timer.Stop();
+      result.expandMs = timer.GetElapsedMilliSec();
+      result.isValid = true;
+      return;
+    }
 
-    err = glz::read_json(m_LastError, response.text);
-    if (err) {
+    glz::error_ctx err = glz::read_json(m_LastError, m_ReceiveBuffer);
+    if (!err) {
       if (m_LastError.errCode == 23) { // No active game error
-        m_State = State::WaitingForNextGame;
+        result.state = State::WaitingForNextGame;
         if (!m_LastError.nextRounds.empty()) {
           const GameRound& nextGame = m_LastError.nextRounds[0];
           CORE_INFO("No active game. Next game '{}' starts at {}", nextGame.name, nextGame.startTime);
+
+          // Both times come from the server clock, so their difference does not depend on the local one
+          auto startTime = ParseServerTime(nextGame.startTime);
+          auto currentTime = ParseServerTime(m_LastError.currentTime);
+          if (startTime && currentTime) {
+            result.nextRoundDelay = std::max(*startTime - *currentTime, std::chrono::milliseconds(0));
+          }
         }
       }
       return;
     }
 
-    CORE_ASSERT(false, "Failed to update server: Failed to parse server response: {}!", glz::format_error(err, response.text));
+    CORE_ERROR("Failed to update server: Failed to parse server response: {}!", glz::format_error(err, m_ReceiveBuffer));
   }
 
-  void Server::Send(std::string_view json) {
-    if (m_State == State::Disconnected) {
-      CORE_ASSERT(false, "Failed to post to the server: server is not connected!");
-      return;
+  cpr::Response Server::Post(cpr::Session& session) {
+    Utils::Timer timer;
+    timer.Start();
+
+    cpr::Response response = session.Post();
+
+    timer.Stop();
+    if (!response.error) {
+      double sample = timer.GetElapsedMilliSec();
+      double roundTripMs = m_RoundTripMs.load(std::memory_order_relaxed);
+      m_RoundTripMs.store(roundTripMs == 0.0 ? sample : roundTripMs + (sample - roundTripMs) * ROUND_TRIP_SMOOTHING,
+                          std::memory_order_relaxed);
     }
 
-    if (m_State == State::WaitingForNextGame) { return; }
+    return response;
+  }
 
-    if (json.empty()) {
-      CORE_ASSERT(false, "Failed to post to the server: json is empty!");
-      return;
+  void Server::StopIo() {
+    {
+      std::lock_guard<std::mutex> lock(m_IoMutex);
+      m_StopIo = true;
     }
+    m_IoCondition.notify_all();
 
-    CORE_INFO("Sending json: {}", json);
-    m_Session.SetBody(cpr::Body(json));
-    cpr::Response response = m_Session.Post();
-    if (response.error) {
-      CORE_ASSERT(false, "Failed to post to the server: {}!", response.error.message);
-      return;
+    {
+      std::lock_guard<std::mutex> lock(m_StreamMutex);
+      m_StopStream = true;
     }
+    m_StreamCondition.notify_all();
+
+    if (m_FetchThread.joinable()) { m_FetchThread.join(); }
+    if (m_SendThread.joinable()) { m_SendThread.join(); }
+    if (m_ParseThread.joinable()) { m_ParseThread.join(); }
+
+    m_IsFetchRequested = false;
+    m_HasPendingSend = false;
   }
 
   void Server::PrintGameState() {
@@ -2,6 +2,12 @@
 
 #include "pch.h"
 
+#include "Game/WorldSnapshot.h"
+
+#include "Utils/SpscQueue.h"
+
+#include <condition_variable>
+
 #include <cpr/cpr.h>
 
 namespace Snake {
@@ -32,7 +38,12 @@ namespace Snake {
     void Connect(std::string_view url, std::string_view token);
     void Disconnect();
 
-    void Update();
+    // Asks the I/O thread for the current state and waits until it has been received and parsed.
+    // Returns false when the fetch failed, the previous state is kept then and is not fresher than before.
+    bool Update();
+
+    // Queues the moves and returns at once, the I/O thread posts them while the caller keeps planning.
+    // Moves that were not posted yet are replaced by newer ones.
     void Send(std::string_view json);
 
     void PrintGameState();
@@ -44,6 +55,55 @@ namespace Snake {
 
     inline const GameState& GetGameState() const noexcept { return m_GameState; }
 
+    // The same state as flat arrays of packed cells, only for the thread calling Update
+    inline const WorldSnapshot& GetSnapshot() const noexcept { return m_Snapshot; }
+
+    // Copies the snapshot for any other thread, Update never swaps it while the copy runs
+    void CopySnapshot(WorldSnapshot& snapshot);
+
+    // Time until the next round starts by the server clock, known while waiting for the next game
+    inline std::optional<std::chrono::milliseconds> GetNextRoundDelay() const noexcept { return m_NextRoundDelay; }
+
+    // Smoothed duration of a full request to the server
+    inline double GetRoundTripMs() const noexcept { return m_RoundTripMs.load(std::memory_order_relaxed); }
+
+    // Time spent expanding the last snapshot into the game state after its body arrived
+    inline double GetExpandMs() const noexcept { return m_ExpandMs; }
+
+    // Time the snapshot of the last state took to finish after its last byte arrived, it is parsed while the body downloads
+    inline double GetSnapshotTailMs() const noexcept { return m_SnapshotTailMs; }
+
+  private:
+    // State fetched by the I/O thread, parsed and expanded into the game state before it is handed over
+    struct FetchResult {
+      GameState gameState;
+      WorldSnapshot snapshot;
+      State state = State::Connected;
+      std::optional<std::chrono::milliseconds> nextRoundDelay;
+      double expandMs = 0.0;
+      double snapshotTailMs = 0.0;
+      bool isValid = false;
+    };
+
+    void FetchLoop();
+    void SendLoop();
+    void ParseLoop();
+
+    // Write callback of state requests, appends a chunk of the body for the parse thread
+    bool ReceiveChunk(std::string_view data);
+
+    // Called by the parse thread, see WorldSnapshot::ReadMore
+    std::string_view WaitForBody(uint64_t position);
+
+    // Starts parsing the next body into the snapshot, and waits until the whole body has been parsed
+    void BeginSnapshot(WorldSnapshot& snapshot);
+    bool FinishSnapshot();
+
+    void Fetch(FetchResult& result);
+    cpr::Response Post(cpr::Session& session);
+
+    void StopIo();
+
   private:
     State m_State = State::Disconnected;
     Error m_LastError;
@@ -52,8 +112,45 @@ namespace Snake {
     std::string m_Token;
 
     GameState m_GameState;
-
-    cpr::Session m_Session;
+    WorldSnapshot m_Snapshot;
+    std::mutex m_SnapshotMutex;
+    std::optional<std::chrono::milliseconds> m_NextRoundDelay;
+    double m_ExpandMs = 0.0;
+    double m_SnapshotTailMs = 0.0;
+
+    // State requests and moves go through separate sessions, so a fetch never waits behind a send
+    cpr::Session m_FetchSession;
+    cpr::Session m_SendSession;
+    std::atomic<double> m_RoundTripMs = 0.0;
+
+    std::thread m_FetchThread;
+    std::thread m_SendThread;
+    std::mutex m_IoMutex;
+    std::condition_variable m_IoCondition;
+    bool m_IsFetchRequested = false;
+    bool m_HasPendingSend = false;
+    bool m_StopIo = false;
+    std::string m_PendingSend;
+    std::string m_SendBuffer;
+
+    // Bodies are received into one buffer that keeps its capacity, and parsed into states that keep theirs,
+    // so a steady stream of ticks parses without allocating. The parse thread reads the buffer while it is still
+    // being written, which is why it only grows while the parse thread waits for more bytes and holds no view into it.
+    std::string m_ReceiveBuffer;
+    SnakeIdTable m_SnakeIds;
+
+    std::thread m_ParseThread;
+    std::mutex m_StreamMutex;
+    std::condition_variable m_StreamCondition;
+    WorldSnapshot* m_StreamTarget = nullptr;
+    bool m_IsBodyComplete = false;
+    bool m_IsParserWaiting = false;
+    bool m_IsSnapshotParsed = false;
+    bool m_IsSnapshotValid = false;
+    bool m_StopStream = false;
+
+    // Written by the fetch thread only, read by the thread calling Update
+    Utils::SpscQueue<FetchResult, 2> m_FetchResults;
   };
 }
 
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <chrono>
+#include <limits>
+
+namespace Snake::Utils {
+	class Deadline {
+	public:
+		// A default constructed deadline never expires
+		Deadline() noexcept = default;
+		explicit Deadline(std::chrono::steady_clock::time_point timePoint) noexcept : m_TimePoint(timePoint) {}
+
+		template <typename Rep, typename Period>
+		static inline Deadline FromNow(std::chrono::duration<Rep, Period> duration) noexcept {
+			return Deadline(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration));
+		}
+
+		inline bool IsExpired() const noexcept {
+			return std::chrono::steady_clock::now() >= m_TimePoint;
+		}
+
+		inline double GetRemainingMilliSec() const noexcept {
+			if (m_TimePoint == std::chrono::steady_clock::time_point::max()) { return std::numeric_limits<double>::infinity(); }
+			return std::chrono::duration<double, std::milli>(m_TimePoint - std::chrono::steady_clock::now()).count();
+		}
+
+		inline std::chrono::steady_clock::time_point GetTimePoint() const noexcept { return m_TimePoint; }
+
+	private:
+		std::chrono::steady_clock::time_point m_TimePoint = std::chrono::steady_clock::time_point::max();
+	};
+}
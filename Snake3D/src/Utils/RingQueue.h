@@ -0,0 +1,54 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace Snake::Utils {
+	// FIFO queue over a power-of-two ring buffer. Storage is kept between uses,
+	// so a queue that has reached its working size never allocates again.
+	template <typename T>
+	class RingQueue {
+	public:
+		RingQueue() = default;
+		explicit RingQueue(uint64_t capacity) { Reserve(capacity); }
+
+		void Reserve(uint64_t capacity) {
+			if (capacity <= m_Buffer.size()) { return; }
+
+			std::vector<T> buffer(std::bit_ceil(capacity));
+			for (uint64_t i = 0; i < GetSize(); ++i) {
+				buffer[i] = std::move(m_Buffer[(m_Head + i) & m_Mask]);
+			}
+
+			m_Tail = GetSize();
+			m_Head = 0;
+			m_Buffer = std::move(buffer);
+			m_Mask = m_Buffer.size() - 1;
+		}
+
+		inline void Push(const T& value) {
+			if (GetSize() == m_Buffer.size()) { Reserve(m_Buffer.empty() ? 64 : m_Buffer.size() * 2); }
+			m_Buffer[m_Tail++ & m_Mask] = value;
+		}
+
+		inline T Pop() noexcept { return std::move(m_Buffer[m_Head++ & m_Mask]); }
+
+		// Takes the newest element instead, for callers using the queue as a deque
+		inline T PopBack() noexcept { return std::move(m_Buffer[--m_Tail & m_Mask]); }
+
+		inline const T& Front() const noexcept { return m_Buffer[m_Head & m_Mask]; }
+
+		inline void Clear() noexcept { m_Head = m_Tail = 0; }
+
+		inline bool IsEmpty() const noexcept { return m_Head == m_Tail; }
+		inline uint64_t GetSize() const noexcept { return m_Tail - m_Head; }
+		inline uint64_t GetCapacity() const noexcept { return m_Buffer.size(); }
+
+	private:
+		std::vector<T> m_Buffer;
+		uint64_t m_Mask = 0;
+		uint64_t m_Head = 0;
+		uint64_t m_Tail = 0;
+	};
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+#include "ThreadPool.h"
+
+namespace Snake::Utils {
+	// Bounded queue between exactly one producer and one consumer thread. Items are written into their slot in place
+	// and the slots are never destroyed, so whatever storage an item owns is reused by the item written after it.
+	template <typename T, uint64_t Capacity>
+	requires (std::has_single_bit(Capacity))
+	class SpscQueue {
+	public:
+		// Producer side: the slot to fill next, nullptr while the queue is full
+		inline T* GetWriteSlot() noexcept {
+			uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+			if (tail - m_Head.load(std::memory_order_acquire) == Capacity) { return nullptr; }
+			return &m_Slots[tail & MASK];
+		}
+
+		// Producer side: publishes the slot returned by GetWriteSlot
+		inline void Push() noexcept {
+			m_Tail.store(m_Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+			m_Tail.notify_one();
+		}
+
+		// Consumer side: the oldest item, nullptr while the queue is empty
+		inline T* GetReadSlot() noexcept {
+			uint64_t head = m_Head.load(std::memory_order_relaxed);
+			if (m_Tail.load(std::memory_order_acquire) == head) { return nullptr; }
+			return &m_Slots[head & MASK];
+		}
+
+		// Consumer side: hands the slot returned by GetReadSlot back to the producer
+		inline void Pop() noexcept {
+			m_Head.store(m_Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		// Consumer side: blocks until an item is ready
+		inline void Wait() const noexcept {
+			m_Tail.wait(m_Head.load(std::memory_order_relaxed), std::memory_order_acquire);
+		}
+
+		inline bool IsEmpty() const noexcept {
+			return m_Tail.load(std::memory_order_acquire) == m_Head.load(std::memory_order_acquire);
+		}
+
+	private:
+		static constexpr uint64_t MASK = Capacity - 1;
+
+		std::array<T, Capacity> m_Slots{};
+		alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_Head = 0;
+		alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> m_Tail = 0;
+	};
+}
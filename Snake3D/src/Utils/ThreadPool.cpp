@@ -0,0 +1,135 @@
+#include "ThreadPool.h"
+
+#include "pch.h"
+
+#if defined(_WIN32)
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <pthread.h>
+	#include <sched.h>
+#endif
+
+namespace Snake::Utils {
+	ThreadPool::ThreadPool(uint32_t workerCount, bool pinWorkers) {
+		if (workerCount == 0) {
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		m_Queues.reserve(workerCount + 1);
+		for (uint32_t i = 0; i < workerCount + 1; ++i) {
+			m_Queues.push_back(std::make_unique<WorkerQueue>());
+		}
+
+		m_Workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i) {
+			m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+
+			// Core 0 is left to the owning thread
+			if (pinWorkers) {
+				PinThread(m_Workers.back(), (i + 1) % std::max(std::thread::hardware_concurrency(), 1u));
+			}
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		m_Running = false;
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_SleepCondition.notify_all();
+
+		for (std::thread& worker : m_Workers) {
+			worker.join();
+		}
+	}
+
+	void ThreadPool::Submit(const Task& task) {
+		WorkerQueue& queue = *m_Queues[GetCurrentSlot()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.tasks.Push(task);
+		}
+
+		m_QueuedTasks.fetch_add(1, std::memory_order_release);
+		{
+			std::lock_guard<std::mutex> lock(m_SleepMutex);
+		}
+		m_SleepCondition.notify_one();
+	}
+
+	void ThreadPool::WorkerLoop(uint32_t slot) {
+		t_Pool = this;
+		t_Slot = slot;
+
+		while (true) {
+			if (TryRunTask(slot, true)) { continue; }
+
+			std::unique_lock<std::mutex> lock(m_SleepMutex);
+			m_SleepCondition.wait(lock, [this] {
+				return m_QueuedTasks.load(std::memory_order_acquire) != 0 || !m_Running;
+			});
+
+			if (!m_Running) { return; }
+		}
+	}
+
+	bool ThreadPool::TryRunTask(uint32_t slot, bool allowStealing) {
+		Task task;
+		if (!TryPop(slot, allowStealing, task)) { return false; }
+
+		++t_TaskDepth;
+		task.run(task.function, task.index, slot);
+		--t_TaskDepth;
+
+		// The submitter may return as soon as the counter drops, nothing of the task is touched after it
+		if (task.remaining != nullptr) {
+			task.remaining->fetch_sub(1, std::memory_order_release);
+		}
+		return true;
+	}
+
+	bool ThreadPool::TryPop(uint32_t slot, bool allowStealing, Task& task) {
+		{
+			WorkerQueue& queue = *m_Queues[slot];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.IsEmpty()) {
+				task = queue.tasks.PopBack();
+				m_QueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		if (!allowStealing) { return false; }
+
+		uint32_t queueCount = static_cast<uint32_t>(m_Queues.size());
+		for (uint32_t i = 1; i < queueCount; ++i) {
+			WorkerQueue& queue = *m_Queues[(slot + i) % queueCount];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.tasks.IsEmpty()) {
+				task = queue.tasks.Pop();
+				m_QueuedTasks.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::PinThread(std::thread& thread, uint32_t core) {
+#if defined(_WIN32)
+		if (SetThreadAffinityMask(static_cast<HANDLE>(thread.native_handle()), DWORD_PTR(1) << core) == 0) {
+			CORE_WARN("Failed to pin worker thread to core {}!", core);
+		}
+#elif defined(__linux__)
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(core, &cpuSet);
+		if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet) != 0) {
+			CORE_WARN("Failed to pin worker thread to core {}!", core);
+		}
+#else
+		CORE_WARN("Failed to pin worker thread to core {}: thread affinity is not supported on this platform!", core);
+#endif
+	}
+}
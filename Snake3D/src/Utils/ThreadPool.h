@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "RingQueue.h"
+
+namespace Snake::Utils {
+	constexpr uint64_t CACHE_LINE_SIZE = 64;
+
+	// Persistent pool with one task deque per worker. Workers pop their own deque from the back and
+	// steal from the front of the others once it runs dry. The thread owning the pool gets an extra
+	// slot, so it can submit work and help running it while it waits.
+	class ThreadPool {
+	public:
+		// Plain record of run(function, index, slot), so queueing a task never allocates once the queues reached their
+		// working size. The function has to outlive the task. The counter, when set, is decremented once the task ran.
+		// Slots index per-thread scratch data.
+		struct Task {
+			void (*run)(void* function, uint32_t index, uint32_t slot) = nullptr;
+			void* function = nullptr;
+			std::atomic<uint32_t>* remaining = nullptr;
+			uint32_t index = 0;
+		};
+
+		// A worker count of zero picks one worker per hardware thread minus the owning thread
+		explicit ThreadPool(uint32_t workerCount = 0, bool pinWorkers = false);
+		ThreadPool(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		void Submit(const Task& task);
+
+		// Runs function(index, slot) for every index in [0, count) and returns once all of them finished.
+		// Called from inside a task it never steals and only runs what is queued on its own slot, callers must not
+		// keep state in their slot data across the call.
+		template <typename Function>
+		void ParallelFor(uint32_t count, Function&& function) {
+			if (count == 0) { return; }
+
+			using Callable = std::remove_reference_t<Function>;
+			std::atomic<uint32_t> remaining = count;
+			Task task{
+				.run = [](void* callable, uint32_t index, uint32_t slot) { (*static_cast<Callable*>(callable))(index, slot); },
+				.function = const_cast<std::remove_const_t<Callable>*>(std::addressof(function)),
+				.remaining = &remaining
+			};
+
+			for (uint32_t i = 0; i < count; ++i) {
+				task.index = i;
+				Submit(task);
+			}
+
+			uint32_t slot = GetCurrentSlot();
+			bool allowStealing = t_TaskDepth == 0;
+			while (remaining.load(std::memory_order_acquire) != 0) {
+				if (!TryRunTask(slot, allowStealing)) {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		inline uint32_t GetWorkerCount() const noexcept { return static_cast<uint32_t>(m_Workers.size()); }
+
+		// Workers use slots [0, workerCount), the owning thread uses the last one
+		inline uint32_t GetSlotCount() const noexcept { return GetWorkerCount() + 1; }
+		inline uint32_t GetCurrentSlot() const noexcept { return t_Pool == this ? t_Slot : GetWorkerCount(); }
+
+	private:
+		struct alignas(CACHE_LINE_SIZE) WorkerQueue {
+			std::mutex mutex;
+			RingQueue<Task> tasks;
+		};
+
+		void WorkerLoop(uint32_t slot);
+
+		bool TryRunTask(uint32_t slot, bool allowStealing);
+		bool TryPop(uint32_t slot, bool allowStealing, Task& task);
+
+		static void PinThread(std::thread& thread, uint32_t core);
+
+	private:
+		std::vector<std::unique_ptr<WorkerQueue>> m_Queues;
+		std::vector<std::thread> m_Workers;
+
+		std::mutex m_SleepMutex;
+		std::condition_variable m_SleepCondition;
+		std::atomic<uint64_t> m_QueuedTasks = 0;
+		std::atomic<bool> m_Running = true;
+
+		static inline thread_local const ThreadPool* t_Pool = nullptr;
+		static inline thread_local uint32_t t_Slot = 0;
+		static inline thread_local uint32_t t_TaskDepth = 0;
+	};
+}
@@ -0,0 +1,64 @@
+#include "TickScheduler.h"
+
+#include "pch.h"
+
+// Time the request should reach the server after the tick began, covers the server publishing the new state
+constexpr double BASE_WAKE_DELAY_MS = 5.0;
+
+// Weight of the newest sample in the tick duration and jitter estimates
+constexpr double TICK_SMOOTHING = 0.1;
+
+namespace Snake::Utils {
+	TickScheduler::TickScheduler(double fallbackTickMs) noexcept
+		: m_TickMs(fallbackTickMs), m_WakeDelayMs(BASE_WAKE_DELAY_MS) {
+	}
+
+	bool TickScheduler::Observe(uint64_t tick, double remainingMs, double roundTripMs) noexcept {
+		// The server measured the remaining time about half a round trip before the state arrived
+		m_HalfRoundTripMs = roundTripMs / 2.0;
+		Clock::time_point tickEnd = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double, std::milli>(remainingMs - m_HalfRoundTripMs));
+
+		if (m_HasPhase && tick == m_LastTick) {
+			// Woke before the server moved on, later wake-ups leave more room
+			++m_EarlyWakes;
+			m_WakeDelayMs = std::min(m_WakeDelayMs * 2.0, m_TickMs / 4.0);
+			m_TickEnd = tickEnd;
+			return false;
+		}
+
+		if (m_HasPhase && tick > m_LastTick) {
+			double elapsedTicks = static_cast<double>(tick - m_LastTick);
+			double sinceLastMs = std::chrono::duration<double, std::milli>(tickEnd - m_TickEnd).count();
+
+			m_LastPhaseErrorMs = sinceLastMs - elapsedTicks * m_TickMs;
+			m_PhaseJitterMs += (std::abs(m_LastPhaseErrorMs) - m_PhaseJitterMs) * TICK_SMOOTHING;
+			m_MaxPhaseErrorMs = std::max(m_MaxPhaseErrorMs, std::abs(m_LastPhaseErrorMs));
+			m_TickMs += (sinceLastMs / elapsedTicks - m_TickMs) * TICK_SMOOTHING;
+
+			// On time again, the wake delay drifts back towards the base
+			m_WakeDelayMs += (BASE_WAKE_DELAY_MS - m_WakeDelayMs) * TICK_SMOOTHING;
+		}
+
+		m_TickEnd = tickEnd;
+		m_LastTick = tick;
+		m_HasPhase = true;
+		return true;
+	}
+
+	void TickScheduler::Reset() noexcept {
+		m_HasPhase = false;
+		m_WakeDelayMs = BASE_WAKE_DELAY_MS;
+	}
+
+	TickScheduler::Clock::time_point TickScheduler::GetNextWakeTime() const noexcept {
+		if (!m_HasPhase) { return Clock::now(); }
+
+		return m_TickEnd + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double, std::milli>(m_WakeDelayMs - m_HalfRoundTripMs));
+	}
+
+	void TickScheduler::SleepUntilNextTick() const {
+		std::this_thread::sleep_until(GetNextWakeTime());
+	}
+}
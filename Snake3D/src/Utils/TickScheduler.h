@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace Snake::Utils {
+	// Learns the phase of the server ticks from the states it receives and wakes the caller once per tick,
+	// timed so the state request reaches the server shortly after the new tick began.
+	class TickScheduler {
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		// The fallback duration is used until two ticks have been observed
+		explicit TickScheduler(double fallbackTickMs = 1000.0) noexcept;
+
+		// Records the state of the given tick with remainingMs left on the server, received now over a request that took roundTripMs.
+		// Returns false when the tick was observed already, the wake-up came too early and is moved later from now on.
+		bool Observe(uint64_t tick, double remainingMs, double roundTripMs) noexcept;
+
+		// Forgets the learned phase, the next observation starts over. The tick duration is kept.
+		void Reset() noexcept;
+
+		// Time the request for the state of the next tick should be sent, right away when nothing was observed yet
+		Clock::time_point GetNextWakeTime() const noexcept;
+
+		void SleepUntilNextTick() const;
+
+		inline double GetTickMs() const noexcept { return m_TickMs; }
+
+		// Difference between where the last tick ended and where the learned phase expected it, positive when it ended late
+		inline double GetLastPhaseErrorMs() const noexcept { return m_LastPhaseErrorMs; }
+
+		// Smoothed absolute phase error, the send margin before the deadline should stay above it
+		inline double GetPhaseJitterMs() const noexcept { return m_PhaseJitterMs; }
+		inline double GetMaxPhaseErrorMs() const noexcept { return m_MaxPhaseErrorMs; }
+
+		inline double GetWakeDelayMs() const noexcept { return m_WakeDelayMs; }
+		inline uint64_t GetEarlyWakeCount() const noexcept { return m_EarlyWakes; }
+
+	private:
+		Clock::time_point m_TickEnd;
+		uint64_t m_LastTick = 0;
+		bool m_HasPhase = false;
+
+		double m_TickMs = 1000.0;
+		double m_HalfRoundTripMs = 0.0;
+		double m_WakeDelayMs = 0.0;
+
+		double m_LastPhaseErrorMs = 0.0;
+		double m_PhaseJitterMs = 0.0;
+		double m_MaxPhaseErrorMs = 0.0;
+		uint64_t m_EarlyWakes = 0;
+	};
+}
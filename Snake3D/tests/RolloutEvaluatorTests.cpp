@@ -0,0 +1,67 @@
+#include "Game/RolloutEvaluator.h"
+
+#include <array>
+#include <cstdio>
+
+using Snake::RolloutEvaluator;
+
+#define CHECK(condition)                                                              \
+  if (!(condition)) {                                                                 \
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+    return false;                                                                     \
+  }
+
+static RolloutEvaluator::MoveStats MakeStats(uint32_t rollouts, uint32_t survived, int64_t value) {
+  return RolloutEvaluator::MoveStats{ rollouts, survived, value, true };
+}
+
+// The deadline stopped the planned direction early, a more valuable direction with the same survival must not win
+static bool KeepsPlannedMoveCutShortByDeadline() {
+  std::array<RolloutEvaluator::MoveStats, 6> stats;
+  stats.fill(MakeStats(64, 64, 0));
+  stats[0] = MakeStats(8, 8, 0);
+  stats[1] = MakeStats(64, 64, 640);
+
+  CHECK(RolloutEvaluator::SelectMove(stats, 0) == 0);
+  return true;
+}
+
+static bool KeepsPlannedMoveWithSameSurvival() {
+  std::array<RolloutEvaluator::MoveStats, 6> stats;
+  stats.fill(MakeStats(64, 64, 0));
+  stats[1] = MakeStats(64, 64, 640);
+
+  CHECK(RolloutEvaluator::SelectMove(stats, 0) == 0);
+  return true;
+}
+
+static bool ReplacesBlockedPlannedMove() {
+  std::array<RolloutEvaluator::MoveStats, 6> stats;
+  stats.fill(MakeStats(64, 32, 0));
+  stats[0] = RolloutEvaluator::MoveStats{};
+  stats[2] = MakeStats(64, 48, 0);
+
+  CHECK(RolloutEvaluator::SelectMove(stats, 0) == 2);
+  return true;
+}
+
+// Survival ranks first, a more valuable direction that dies more often loses
+static bool RanksBySurvivalBeforeValue() {
+  std::array<RolloutEvaluator::MoveStats, 6> stats;
+  stats.fill(MakeStats(64, 16, 0));
+  stats[1] = MakeStats(64, 48, 1000);
+  stats[2] = MakeStats(64, 64, 10);
+  stats[3] = MakeStats(64, 64, 20);
+
+  CHECK(RolloutEvaluator::SelectMove(stats, 0) == 3);
+  return true;
+}
+
+int main() {
+  bool passed = true;
+  passed &= KeepsPlannedMoveCutShortByDeadline();
+  passed &= KeepsPlannedMoveWithSameSurvival();
+  passed &= ReplacesBlockedPlannedMove();
+  passed &= RanksBySurvivalBeforeValue();
+  return passed ? 0 : 1;
+}